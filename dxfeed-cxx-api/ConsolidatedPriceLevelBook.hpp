@@ -0,0 +1,280 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "FlatHashMap.hpp"
+#include "PriceLevel.hpp"
+#include "PriceLevelBook.hpp"
+#include "PriceLevelBookCore.hpp"
+#include "PriceLevelLadder.hpp"
+
+namespace dxf {
+
+/*
+ * The price level book of one symbol consolidated across several sources. Each source is a PriceLevelBook with the
+ * same levels number: a price that is not visible in a source book can not be visible in the consolidated book.
+ *
+ * The book keeps the contribution of every source to every price level. A change of a source book touches only the
+ * changed prices: their consolidated sizes are recomputed from the contributions and the differences are applied to
+ * the consolidated levels (the same PriceLevelBookCore algorithm that honors the levels number). The sizes are summed
+ * in the fixed point, so the consolidated levels are removed exactly when the last source leaves the price.
+ */
+class ConsolidatedPriceLevelBook final {
+  using Numbers = FixedPointPriceLevelNumbers;
+  using Core = PriceLevelBookCore<Numbers, OrderedPriceLevelLadder<FixedPointPriceLevel>>;
+  using Sizes = FlatHashMap<std::int64_t, std::int64_t>;
+
+  struct Source {
+    std::string name;
+    Sizes askSizes;
+    Sizes bidSizes;
+    std::unique_ptr<PriceLevelBook> book;
+  };
+
+  std::string symbol_;
+  Numbers numbers_;
+  std::vector<Source> sources_;
+
+  std::mutex mutex_;
+  Core core_;
+  Sizes askSizes_;
+  Sizes bidSizes_;
+
+  // The scratch buffers
+  std::vector<std::int64_t> changedAskPrices_;
+  std::vector<std::int64_t> changedBidPrices_;
+  BasicPriceLevelChanges<FixedPointPriceLevel> levelChanges_;
+  PriceLevelChangesSet changesSet_;
+  PriceLevelChanges book_;
+
+  std::function<void(const PriceLevelChanges&)> onBookUpdate_;
+  std::function<void(const PriceLevelChangesSet&)> onIncrementalChange_;
+
+  ConsolidatedPriceLevelBook(std::string symbol, std::size_t levelsNumber, const PriceLevelBookOptions& options)
+      : symbol_{std::move(symbol)},
+        numbers_{options.priceScale, options.sizeScale},
+        sources_{},
+        mutex_{},
+        core_{numbers_, levelsNumber, options.tickSize},
+        askSizes_{},
+        bidSizes_{},
+        changedAskPrices_{},
+        changedBidPrices_{},
+        levelChanges_{},
+        changesSet_{},
+        book_{} {}
+
+  static void setSizes(Sizes& sizes, const std::vector<PriceLevel>& priceLevels, const Numbers& numbers,
+                       std::vector<std::int64_t>& changedPrices) {
+    for (const auto& priceLevel : priceLevels) {
+      // The source books are not limited by the range of the consolidated numbers
+      if (!numbers.isValid(priceLevel.price, priceLevel.size)) continue;
+
+      auto price = numbers.toPrice(priceLevel.price);
+
+      sizes[price] = numbers.toSize(priceLevel.size);
+      changedPrices.push_back(price);
+    }
+  }
+
+  static void eraseSizes(Sizes& sizes, const std::vector<PriceLevel>& priceLevels, const Numbers& numbers,
+                         std::vector<std::int64_t>& changedPrices) {
+    for (const auto& priceLevel : priceLevels) {
+      auto price = numbers.toPrice(priceLevel.price);
+
+      sizes.erase(price);
+      changedPrices.push_back(price);
+    }
+  }
+
+  // Recomputes the consolidated sizes of the changed prices and collects the differences (best first)
+  void collectLevelChanges(PriceLevelSide side, std::vector<std::int64_t>& changedPrices,
+                           std::vector<FixedPointPriceLevel>& levelChanges, std::int64_t time) {
+    auto& consolidatedSizes = side == PriceLevelSide::BID ? bidSizes_ : askSizes_;
+
+    levelChanges.clear();
+
+    if (side == PriceLevelSide::BID) {
+      std::sort(changedPrices.begin(), changedPrices.end(), std::greater<>{});
+    } else {
+      std::sort(changedPrices.begin(), changedPrices.end());
+    }
+
+    changedPrices.erase(std::unique(changedPrices.begin(), changedPrices.end()), changedPrices.end());
+
+    for (auto price : changedPrices) {
+      std::int64_t size = 0;
+
+      for (const auto& source : sources_) {
+        const auto* sourceSize = (side == PriceLevelSide::BID ? source.bidSizes : source.askSizes).find(price);
+
+        if (sourceSize != nullptr) size += *sourceSize;
+      }
+
+      const auto* oldSize = consolidatedSizes.find(price);
+      auto difference = size - (oldSize != nullptr ? *oldSize : 0);
+
+      if (difference == 0) continue;
+
+      if (size == 0) {
+        consolidatedSizes.erase(price);
+      } else {
+        consolidatedSizes[price] = size;
+      }
+
+      levelChanges.push_back({price, difference, time});
+    }
+
+    changedPrices.clear();
+  }
+
+  // Applies the changes of the source book. `isNewBook` - the changes are the whole new book of the source.
+  void applySourceChanges(std::size_t sourceIndex, const PriceLevelChangesSet& changesSet, bool isNewBook) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto& source = sources_[sourceIndex];
+    std::int64_t time = 0;
+
+    if (isNewBook) {
+      source.askSizes.forEach([this](std::int64_t price, std::int64_t) { changedAskPrices_.push_back(price); });
+      source.bidSizes.forEach([this](std::int64_t price, std::int64_t) { changedBidPrices_.push_back(price); });
+      source.askSizes.clear();
+      source.bidSizes.clear();
+    }
+
+    eraseSizes(source.askSizes, changesSet.removals.asks, numbers_, changedAskPrices_);
+    eraseSizes(source.bidSizes, changesSet.removals.bids, numbers_, changedBidPrices_);
+    setSizes(source.askSizes, changesSet.additions.asks, numbers_, changedAskPrices_);
+    setSizes(source.bidSizes, changesSet.additions.bids, numbers_, changedBidPrices_);
+    setSizes(source.askSizes, changesSet.updates.asks, numbers_, changedAskPrices_);
+    setSizes(source.bidSizes, changesSet.updates.bids, numbers_, changedBidPrices_);
+
+    for (const auto* priceLevels : {&changesSet.additions.asks, &changesSet.additions.bids, &changesSet.updates.asks,
+                                    &changesSet.updates.bids}) {
+      for (const auto& priceLevel : *priceLevels) time = (std::max)(time, priceLevel.time);
+    }
+
+    collectLevelChanges(PriceLevelSide::ASK, changedAskPrices_, levelChanges_.asks, time);
+    collectLevelChanges(PriceLevelSide::BID, changedBidPrices_, levelChanges_.bids, time);
+
+    if (levelChanges_.asks.empty() && levelChanges_.bids.empty()) return;
+
+    auto version = core_.getVersion();
+
+    core_.applyUpdates(levelChanges_, changesSet_);
+
+    // The changes are not visible
+    if (core_.getVersion() == version) return;
+
+    if (onIncrementalChange_) {
+      onIncrementalChange_(changesSet_);
+    }
+
+    if (onBookUpdate_) {
+      core_.copyBook(book_);
+      onBookUpdate_(book_);
+    }
+  }
+
+ public:
+  /*
+   * Creates the books of the sources and subscribes them. The sources books that were not subscribed are still created
+   * (see PriceLevelBook::create). `options` are the options of the source books, the consolidated sizes are summed with
+   * the options.priceScale and options.sizeScale. The checkpointPath option is ignored: the restored source book is not
+   * notified, so the consolidated book would miss its levels until the next snapshot.
+   */
+  static std::unique_ptr<ConsolidatedPriceLevelBook> create(dxf_connection_t connection, const std::string& symbol,
+                                                            const std::vector<std::string>& sources,
+                                                            std::size_t levelsNumber,
+                                                            const PriceLevelBookOptions& options = {}) {
+    auto book =
+      std::unique_ptr<ConsolidatedPriceLevelBook>(new ConsolidatedPriceLevelBook(symbol, levelsNumber, options));
+
+    auto sourceOptions = options;
+
+    sourceOptions.checkpointPath.clear();
+    book->sources_.reserve(sources.size());
+
+    for (const auto& source : sources) {
+      auto sourceBook =
+        std::unique_ptr<PriceLevelBook>(new PriceLevelBook(symbol, source, levelsNumber, sourceOptions));
+
+      book->sources_.push_back(Source{source, {}, {}, std::move(sourceBook)});
+    }
+
+    for (std::size_t i = 0; i < book->sources_.size(); i++) {
+      auto& sourceBook = *book->sources_[i].book;
+      auto* consolidatedBook = book.get();
+
+      sourceBook.setOnNewBook([consolidatedBook, i](const PriceLevelChanges& newBook) {
+        consolidatedBook->applySourceChanges(i, PriceLevelChangesSet{newBook, {}, {}}, true);
+      });
+      sourceBook.setOnIncrementalChange([consolidatedBook, i](const PriceLevelChangesSet& changesSet) {
+        consolidatedBook->applySourceChanges(i, changesSet, false);
+      });
+      sourceBook.subscribe(connection);
+    }
+
+    return book;
+  }
+
+  ConsolidatedPriceLevelBook(const ConsolidatedPriceLevelBook&) = delete;
+  ConsolidatedPriceLevelBook& operator=(const ConsolidatedPriceLevelBook&) = delete;
+
+  ~ConsolidatedPriceLevelBook() {
+    // The source books are stopped before the consolidated state is destroyed
+    for (auto& source : sources_) {
+      source.book.reset();
+    }
+  }
+
+  [[nodiscard]] const std::string& getSymbol() const { return symbol_; }
+
+  // Returns the book of the source or nullptr
+  [[nodiscard]] PriceLevelBook* getSourceBook(const std::string& source) const {
+    for (const auto& s : sources_) {
+      if (s.name == source) return s.book.get();
+    }
+
+    return nullptr;
+  }
+
+  // Returns the copy of the consolidated visible book
+  [[nodiscard]] PriceLevelChanges getBook() {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return PriceLevelChanges{core_.getAsks(), core_.getBids()};
+  }
+
+  // Calls the f(const std::string& source, double size) for the sources that contribute to the consolidated price
+  // level
+  template <typename F>
+  void forEachContribution(PriceLevelSide side, double price, F&& f) {
+    std::lock_guard<std::mutex> lk(mutex_);
+    auto fixedPointPrice = numbers_.toPrice(price);
+
+    for (const auto& source : sources_) {
+      const auto* size = (side == PriceLevelSide::BID ? source.bidSizes : source.askSizes).find(fixedPointPrice);
+
+      if (size != nullptr) f(source.name, numbers_.fromSize(*size));
+    }
+  }
+
+  void setOnBookUpdate(std::function<void(const PriceLevelChanges&)> onBookUpdateHandler) {
+    onBookUpdate_ = std::move(onBookUpdateHandler);
+  }
+
+  void setOnIncrementalChange(std::function<void(const PriceLevelChangesSet&)> onIncrementalChangeHandler) {
+    onIncrementalChange_ = std::move(onIncrementalChangeHandler);
+  }
+};
+
+}  // namespace dxf
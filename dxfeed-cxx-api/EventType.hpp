@@ -1,20 +1,22 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 
 namespace dxf {
 
-template <typename SymbolType>
-struct EventType {
-  [[nodiscard]] virtual const SymbolType &getEventSymbol() const = 0;
-
-  virtual void setEventSymbol(const SymbolType &eventSymbol) = 0;
-
-  virtual std::uint64_t getEventTime() { return 0; }
-
-  virtual void setEventTime(std::uint64_t eventTime) {}
-
-  virtual ~EventType() = default;
+/*
+ * The event with the symbol and the time. The events are the plain classes without the virtual functions: the common
+ * parts are the CRTP mixins (MarketEvent, IndexedEvent, TimeSeriesEvent) and the generic code is constrained by the
+ * concepts (EventType, IndexedEventType, TimeSeriesEventType), so the getters are inlined.
+ */
+template <typename Event>
+concept EventType = requires(Event& event, const Event& constEvent, std::uint64_t eventTime) {
+  typename Event::SymbolType;
+  { constEvent.getEventSymbol() } -> std::convertible_to<const typename Event::SymbolType&>;
+  event.setEventSymbol(constEvent.getEventSymbol());
+  { constEvent.getEventTime() } -> std::convertible_to<std::uint64_t>;
+  event.setEventTime(eventTime);
 };
 
-}  // namespace dxf
\ No newline at end of file
+}  // namespace dxf
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace dxf {
+
+// The hash of the integer and floating point keys of the FlatHashMap. The low bits are well mixed.
+template <typename Key>
+struct FlatHash {
+  static_assert(std::is_integral_v<Key> || std::is_floating_point_v<Key>, "FlatHash supports only the numeric keys");
+
+  std::size_t operator()(Key key) const {
+    std::uint64_t x = 0;
+
+    if constexpr (std::is_floating_point_v<Key>) {
+      // -0.0 == 0.0
+      x = std::bit_cast<std::uint64_t>(static_cast<double>(key == 0 ? 0 : key));
+    } else {
+      x = static_cast<std::uint64_t>(key);
+    }
+
+    x ^= x >> 33U;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33U;
+
+    return static_cast<std::size_t>(x);
+  }
+};
+
+/*
+ * The open addressing hash map with the linear probing and the backward shift deletion (no tombstones). The keys and
+ * the values are stored inline in one array, the capacity is a power of two, the load factor is at most 3/4.
+ *
+ * The pointers to the values are invalidated by the insertions and the removals.
+ */
+template <typename Key, typename Value, typename Hash = FlatHash<Key>>
+class FlatHashMap final {
+  struct Slot {
+    Key key;
+    Value value;
+  };
+
+  static constexpr std::size_t MIN_CAPACITY = 16;
+
+  std::vector<Slot> slots_;
+  std::vector<std::uint8_t> used_;
+  std::size_t size_;
+  std::size_t mask_;
+  Hash hash_;
+
+  [[nodiscard]] std::size_t home(const Key& key) const { return hash_(key) & mask_; }
+
+  // Returns the slot of the key or the empty slot where it should be inserted. The map must not be full.
+  [[nodiscard]] std::size_t probe(const Key& key) const {
+    for (auto i = home(key);; i = (i + 1) & mask_) {
+      if (used_[i] == 0 || slots_[i].key == key) return i;
+    }
+  }
+
+  static std::size_t capacityFor(std::size_t size) {
+    std::size_t capacity = MIN_CAPACITY;
+
+    while (capacity / 4 * 3 < size) capacity *= 2;
+
+    return capacity;
+  }
+
+  void rehash(std::size_t capacity) {
+    auto oldSlots = std::move(slots_);
+    auto oldUsed = std::move(used_);
+
+    slots_ = std::vector<Slot>(capacity);
+    used_ = std::vector<std::uint8_t>(capacity, 0);
+    mask_ = capacity - 1;
+
+    for (std::size_t i = 0; i < oldSlots.size(); i++) {
+      if (oldUsed[i] == 0) continue;
+
+      auto slot = probe(oldSlots[i].key);
+
+      slots_[slot] = std::move(oldSlots[i]);
+      used_[slot] = 1;
+    }
+  }
+
+  // Removes the element in the slot and shifts the following elements of the cluster back
+  void eraseSlot(std::size_t i) {
+    used_[i] = 0;
+
+    for (auto j = (i + 1) & mask_; used_[j] != 0; j = (j + 1) & mask_) {
+      auto k = home(slots_[j].key);
+
+      // The element stays if its home slot is in the cyclic range (i, j]
+      auto stays = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+
+      if (stays) continue;
+
+      slots_[i] = std::move(slots_[j]);
+      used_[i] = 1;
+      used_[j] = 0;
+      i = j;
+    }
+
+    size_--;
+  }
+
+ public:
+  FlatHashMap() : slots_{}, used_{}, size_{0}, mask_{0}, hash_{} {}
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  [[nodiscard]] std::size_t capacity() const { return slots_.size(); }
+
+  // Returns the pointer to the value or nullptr
+  [[nodiscard]] Value* find(const Key& key) {
+    if (size_ == 0) return nullptr;
+
+    auto slot = probe(key);
+
+    return used_[slot] != 0 ? &slots_[slot].value : nullptr;
+  }
+
+  [[nodiscard]] const Value* find(const Key& key) const {
+    if (size_ == 0) return nullptr;
+
+    auto slot = probe(key);
+
+    return used_[slot] != 0 ? &slots_[slot].value : nullptr;
+  }
+
+  [[nodiscard]] bool contains(const Key& key) const { return find(key) != nullptr; }
+
+  // Returns the value of the key, inserts the value-initialized value if there is no such key
+  Value& operator[](const Key& key) {
+    if ((size_ + 1) > slots_.size() / 4 * 3) {
+      rehash(capacityFor(size_ + 1));
+    }
+
+    auto slot = probe(key);
+
+    if (used_[slot] == 0) {
+      slots_[slot].key = key;
+      slots_[slot].value = Value{};
+      used_[slot] = 1;
+      size_++;
+    }
+
+    return slots_[slot].value;
+  }
+
+  // Returns false if there was no such key
+  bool erase(const Key& key) {
+    if (size_ == 0) return false;
+
+    auto slot = probe(key);
+
+    if (used_[slot] == 0) return false;
+
+    eraseSlot(slot);
+
+    return true;
+  }
+
+  // Removes all the elements, keeps the capacity
+  void clear() {
+    if (size_ == 0) return;
+
+    std::fill(used_.begin(), used_.end(), 0);
+    size_ = 0;
+  }
+
+  // Preallocates the capacity for the `size` elements
+  void reserve(std::size_t size) {
+    auto capacity = capacityFor(size);
+
+    if (capacity > slots_.size()) {
+      rehash(capacity);
+    }
+  }
+
+  // Calls the f(const Key&, const Value&) for all the elements in the unspecified order
+  template <typename F>
+  void forEach(F&& f) const {
+    for (std::size_t i = 0; i < slots_.size(); i++) {
+      if (used_[i] != 0) f(slots_[i].key, slots_[i].value);
+    }
+  }
+};
+
+}  // namespace dxf
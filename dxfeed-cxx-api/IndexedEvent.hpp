@@ -1,5 +1,6 @@
 #pragma once
 
+#include <concepts>
 #include <cstdint>
 #include <string>
 
@@ -14,26 +15,49 @@ struct IndexedEventSource {
   std::string name;
 };
 
-const IndexedEventSource IndexedEventSource::DEFAULT = IndexedEventSource{0, "DEFAULT"};
+inline const IndexedEventSource IndexedEventSource::DEFAULT = IndexedEventSource{0, "DEFAULT"};
+
+// The event of the indexed collection (for example, the order book or the time series)
+template <typename Event>
+concept IndexedEventType = EventType<Event> && requires(Event& event, const Event& constEvent, std::uint32_t flags,
+                                                         std::uint64_t index) {
+  { constEvent.getSource() } -> std::convertible_to<const IndexedEventSource&>;
+  { constEvent.getEventFlags() } -> std::convertible_to<std::uint32_t>;
+  event.setEventFlags(flags);
+  { constEvent.getIndex() } -> std::convertible_to<std::uint64_t>;
+  event.setIndex(index);
+};
+
+/*
+ * The CRTP mixin of the indexed events: the event flags and the index. The fields are the members of the event class
+ * (`eventFlags_`, `index_`). The source is the DEFAULT one unless the event class hides getSource.
+ */
+template <typename Event>
+class IndexedEvent {
+  [[nodiscard]] const Event& self() const { return static_cast<const Event&>(*this); }
+
+  Event& self() { return static_cast<Event&>(*this); }
+
+ protected:
+  IndexedEvent() = default;
 
-template <typename SymbolType>
-struct IndexedEvent : public virtual EventType<SymbolType> {
-  static const std::uint32_t TX_PENDING = 0x01;
-  static const std::uint32_t REMOVE_EVENT = 0x02;
-  static const std::uint32_t SNAPSHOT_BEGIN = 0x04;
-  static const std::uint32_t SNAPSHOT_END = 0x08;
-  static const std::uint32_t SNAPSHOT_SNIP = 0x10;
-  static const std::uint32_t SNAPSHOT_MODE = 0x40;
+ public:
+  static constexpr std::uint32_t TX_PENDING = 0x01;
+  static constexpr std::uint32_t REMOVE_EVENT = 0x02;
+  static constexpr std::uint32_t SNAPSHOT_BEGIN = 0x04;
+  static constexpr std::uint32_t SNAPSHOT_END = 0x08;
+  static constexpr std::uint32_t SNAPSHOT_SNIP = 0x10;
+  static constexpr std::uint32_t SNAPSHOT_MODE = 0x40;
 
-  virtual IndexedEventSource getSource() = 0;
+  [[nodiscard]] const IndexedEventSource& getSource() const { return IndexedEventSource::DEFAULT; }
 
-  virtual std::uint32_t getEventFlags() = 0;
+  [[nodiscard]] std::uint32_t getEventFlags() const { return self().eventFlags_; }
 
-  virtual void setEventFlags(std::uint32_t eventFlags) = 0;
+  void setEventFlags(std::uint32_t eventFlags) { self().eventFlags_ = eventFlags; }
 
-  virtual std::uint64_t getIndex() = 0;
+  [[nodiscard]] std::uint64_t getIndex() const { return self().index_; }
 
-  virtual void setIndex(std::uint64_t index) = 0;
+  void setIndex(std::uint64_t index) { self().index_ = index; }
 };
 
-}  // namespace dxf
\ No newline at end of file
+}  // namespace dxf
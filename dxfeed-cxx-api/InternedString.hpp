@@ -0,0 +1,152 @@
+#pragma once
+
+#include <cstddef>
+#include <cwchar>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "StringConverter.hpp"
+
+namespace dxf {
+
+/*
+ * The thread-safe table of the interned strings: every distinct string is stored once and never moves or is removed,
+ * so the events keep only the pointers to them. The table is for the small sets of distinct values (the symbols, the
+ * sale conditions, the market makers). Every thread caches the strings it has found, so the hot lookups take no
+ * locks; the misses read the table under the shared lock, only the new strings take the exclusive lock and allocate.
+ */
+class StringTable final {
+  template <typename Char>
+  struct Hash {
+    using is_transparent = void;
+
+    std::size_t operator()(std::basic_string_view<Char> s) const {
+      return std::hash<std::basic_string_view<Char>>{}(s);
+    }
+  };
+
+  mutable std::shared_mutex mutex_;
+  // The nodes of the unordered containers are stable
+  std::unordered_set<std::string, Hash<char>, std::equal_to<>> strings_;
+  // The cache of the UTF-16 (the C API strings) to UTF-8 conversions
+  std::unordered_map<std::wstring, const std::string*, Hash<wchar_t>, std::equal_to<>> wideStrings_;
+
+  template <typename Char>
+  using Cache = std::unordered_map<std::basic_string<Char>, const std::string*, Hash<Char>, std::equal_to<>>;
+
+  StringTable() : mutex_{}, strings_{}, wideStrings_{} {}
+
+  // The per-thread cache of the found strings (the table is the singleton and does not remove them)
+  template <typename Char>
+  static Cache<Char>& getThreadCache() {
+    thread_local Cache<Char> cache{};
+
+    return cache;
+  }
+
+  const std::string* find(std::string_view s) {
+    {
+      std::shared_lock lock(mutex_);
+
+      if (auto found = strings_.find(s); found != strings_.end()) return &*found;
+    }
+
+    std::unique_lock lock(mutex_);
+
+    return &*strings_.emplace(s).first;
+  }
+
+  const std::string* find(std::wstring_view s) {
+    {
+      std::shared_lock lock(mutex_);
+
+      if (auto found = wideStrings_.find(s); found != wideStrings_.end()) return found->second;
+    }
+
+    auto utf8 = StringConverter::wStringToUtf8(std::wstring{s});
+    std::unique_lock lock(mutex_);
+    const std::string* result = utf8.empty() ? &EMPTY : &*strings_.emplace(std::move(utf8)).first;
+
+    wideStrings_.emplace(s, result);
+
+    return result;
+  }
+
+  template <typename Char>
+  const std::string* findCached(std::basic_string_view<Char> s) {
+    auto& cache = getThreadCache<Char>();
+
+    if (auto found = cache.find(s); found != cache.end()) return found->second;
+
+    const std::string* result = find(s);
+
+    cache.emplace(s, result);
+
+    return result;
+  }
+
+ public:
+  static const std::string EMPTY;
+
+  StringTable(const StringTable&) = delete;
+  StringTable& operator=(const StringTable&) = delete;
+
+  static StringTable& getInstance() {
+    static StringTable instance{};
+
+    return instance;
+  }
+
+  // Returns the stable pointer to the interned copy of the string
+  const std::string* intern(std::string_view s) {
+    if (s.empty()) return &EMPTY;
+
+    return findCached(s);
+  }
+
+  // Returns the stable pointer to the interned UTF-8 copy of the UTF-16 string. The string is converted only once.
+  const std::string* intern(const wchar_t* s) {
+    if (s == nullptr || *s == L'\0') return &EMPTY;
+
+    return findCached(std::wstring_view{s});
+  }
+
+  // The number of the distinct strings
+  [[nodiscard]] std::size_t getSize() const {
+    std::shared_lock lock(mutex_);
+
+    return strings_.size();
+  }
+};
+
+inline const std::string StringTable::EMPTY{};
+
+/*
+ * The handle of the string interned by the StringTable: the pointer, so it is trivially copyable and compared by the
+ * address.
+ */
+class InternedString final {
+  const std::string* value_;
+
+ public:
+  InternedString() : value_{&StringTable::EMPTY} {}
+
+  explicit InternedString(std::string_view s) : value_{StringTable::getInstance().intern(s)} {}
+
+  explicit InternedString(const wchar_t* s) : value_{StringTable::getInstance().intern(s)} {}
+
+  [[nodiscard]] const std::string& get() const { return *value_; }
+
+  operator const std::string&() const { return *value_; }  // NOLINT(google-explicit-constructor)
+
+  [[nodiscard]] bool empty() const { return value_->empty(); }
+
+  bool operator==(const InternedString& other) const { return value_ == other.value_; }
+};
+
+}  // namespace dxf
@@ -4,26 +4,34 @@
 #include <string>
 
 #include "EventType.hpp"
+#include "InternedString.hpp"
 
 namespace dxf {
 
-class MarketEvent : public virtual EventType<std::string> {
-  std::string eventSymbol_{};
-  std::uint64_t eventTime_{};
+/*
+ * The CRTP mixin of the market events: the accessors of the event symbol and the event time. The fields are the
+ * members of the event class (`eventSymbol_`, `eventTime_`), so the event stays a standard-layout class. The event
+ * symbol is interned (see InternedString).
+ */
+template <typename Event>
+class MarketEvent {
+  [[nodiscard]] const Event& self() const { return static_cast<const Event&>(*this); }
+
+  Event& self() { return static_cast<Event&>(*this); }
 
  protected:
   MarketEvent() = default;
 
-  explicit MarketEvent(std::string eventSymbol) : eventSymbol_{std::move(eventSymbol)} {}
-
  public:
-  [[nodiscard]] const std::string &getEventSymbol() const override { return eventSymbol_; }
+  using SymbolType = std::string;
+
+  [[nodiscard]] const std::string& getEventSymbol() const { return self().eventSymbol_.get(); }
 
-  void setEventSymbol(const std::string &eventSymbol) override { eventSymbol_ = eventSymbol; }
+  void setEventSymbol(const std::string& eventSymbol) { self().eventSymbol_ = InternedString{eventSymbol}; }
 
-  std::uint64_t getEventTime() override { return eventTime_; }
+  [[nodiscard]] std::uint64_t getEventTime() const { return self().eventTime_; }
 
-  void setEventTime(std::uint64_t eventTime) override { eventTime_ = eventTime; }
+  void setEventTime(std::uint64_t eventTime) { self().eventTime_ = eventTime; }
 };
 
-}  // namespace dxf
\ No newline at end of file
+}  // namespace dxf
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <cstddef>
+
+#include "FlatHashMap.hpp"
+
+namespace dxf {
+
+template <typename Number>
+struct BasicOrderData {
+  dxf_long_t index = 0;
+  Number price{};
+  Number size{};
+  dxf_long_t time = 0;
+  dxf_order_side_t side = dxf_osd_undefined;
+};
+
+using OrderData = BasicOrderData<double>;
+
+/*
+ * The orders of the book by the order index. The order data is stored inline in the open addressing map, the map does
+ * not allocate until it grows. The order stores (OrderIndex, OrderQueueBook) have the same interface:
+ * find, put (insert or replace), erase, clear, reserve, size, forEach.
+ */
+template <typename Number>
+class OrderIndex final {
+  FlatHashMap<dxf_long_t, BasicOrderData<Number>> orders_;
+
+ public:
+  OrderIndex() = default;
+
+  // Returns the pointer to the order data or nullptr. The pointer is valid until the next change of the index.
+  [[nodiscard]] const BasicOrderData<Number>* find(dxf_long_t index) const {
+    return orders_.find(index);
+  }
+
+  void put(const BasicOrderData<Number>& orderData) { orders_[orderData.index] = orderData; }
+
+  void erase(dxf_long_t index) { orders_.erase(index); }
+
+  void clear() { orders_.clear(); }
+
+  void reserve(std::size_t ordersNumber) { orders_.reserve(ordersNumber); }
+
+  [[nodiscard]] std::size_t size() const { return orders_.size(); }
+
+  // Calls the f(const BasicOrderData<Number>&) for all the orders in the unspecified order
+  template <typename F>
+  void forEach(F&& f) const {
+    orders_.forEach([&f](dxf_long_t, const BasicOrderData<Number>& orderData) { f(orderData); });
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,212 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <cstddef>
+#include <optional>
+
+#include "FlatHashMap.hpp"
+#include "OrderIndex.hpp"
+#include "SlabPool.hpp"
+
+namespace dxf {
+
+// The position of the order in the queue of its price
+struct OrderQueuePosition {
+  dxf_order_side_t side = dxf_osd_undefined;
+  double price = 0.0;
+
+  // The orders and their total size before the order
+  std::size_t ordersAhead = 0;
+  double sizeAhead = 0.0;
+
+  std::size_t queueOrdersNumber = 0;
+  double queueSize = 0.0;
+};
+
+template <typename Number>
+struct OrderQueue;
+
+// The order linked into the FIFO queue of its price
+template <typename Number>
+struct OrderNode {
+  BasicOrderData<Number> data{};
+  OrderNode* previous = nullptr;
+  OrderNode* next = nullptr;
+  OrderQueue<Number>* queue = nullptr;
+};
+
+// The orders of one price of one side in the order of their arrival
+template <typename Number>
+struct OrderQueue {
+  Number price{};
+  Number size{};
+  std::size_t ordersNumber = 0;
+  OrderNode<Number>* head = nullptr;
+  OrderNode<Number>* tail = nullptr;
+};
+
+/*
+ * The market-by-order book: the per-price FIFO queues of the orders. The order nodes and the queues are taken from the
+ * slab pools and linked intrusively, the add, modify and cancel by the order index are O(1).
+ *
+ * A modification keeps the queue position of the order if the side and the price are the same and the size is not
+ * increased. Otherwise, the order is moved to the end of the queue of its (new) price.
+ *
+ * It is the order store of the PriceLevelBookCore (see OrderIndex) when the book tracks the orders.
+ */
+template <typename Number>
+class OrderQueueBook final {
+  using Node = OrderNode<Number>;
+  using Queue = OrderQueue<Number>;
+
+  SlabPool<Node> nodes_;
+  SlabPool<Queue> queues_;
+  FlatHashMap<dxf_long_t, Node*> orders_;
+  FlatHashMap<Number, Queue*> askQueues_;
+  FlatHashMap<Number, Queue*> bidQueues_;
+
+  FlatHashMap<Number, Queue*>& getQueues(dxf_order_side_t side) {
+    return side == dxf_osd_buy ? bidQueues_ : askQueues_;
+  }
+
+  [[nodiscard]] const FlatHashMap<Number, Queue*>& getQueues(dxf_order_side_t side) const {
+    return side == dxf_osd_buy ? bidQueues_ : askQueues_;
+  }
+
+  void link(Node* node) {
+    auto& queue = getQueues(node->data.side)[node->data.price];
+
+    if (queue == nullptr) {
+      queue = queues_.acquire();
+      *queue = Queue{node->data.price};
+    }
+
+    node->queue = queue;
+    node->previous = queue->tail;
+    node->next = nullptr;
+
+    if (queue->tail != nullptr) {
+      queue->tail->next = node;
+    } else {
+      queue->head = node;
+    }
+
+    queue->tail = node;
+    queue->ordersNumber++;
+    queue->size += node->data.size;
+  }
+
+  void unlink(Node* node) {
+    auto* queue = node->queue;
+
+    if (node->previous != nullptr) {
+      node->previous->next = node->next;
+    } else {
+      queue->head = node->next;
+    }
+
+    if (node->next != nullptr) {
+      node->next->previous = node->previous;
+    } else {
+      queue->tail = node->previous;
+    }
+
+    queue->size -= node->data.size;
+
+    if (--queue->ordersNumber == 0) {
+      getQueues(node->data.side).erase(queue->price);
+      queues_.release(queue);
+    }
+
+    node->queue = nullptr;
+  }
+
+ public:
+  OrderQueueBook() = default;
+
+  // Returns the pointer to the order data or nullptr. The pointer is valid until the order is removed.
+  [[nodiscard]] const BasicOrderData<Number>* find(dxf_long_t index) const {
+    const auto* found = orders_.find(index);
+
+    return found == nullptr ? nullptr : &(*found)->data;
+  }
+
+  [[nodiscard]] const Node* findOrder(dxf_long_t index) const {
+    const auto* found = orders_.find(index);
+
+    return found == nullptr ? nullptr : *found;
+  }
+
+  // Returns the queue of the price or nullptr
+  [[nodiscard]] const Queue* findQueue(dxf_order_side_t side, Number price) const {
+    const auto* found = getQueues(side).find(price);
+
+    return found == nullptr ? nullptr : *found;
+  }
+
+  void put(const BasicOrderData<Number>& orderData) {
+    auto& node = orders_[orderData.index];
+
+    if (node == nullptr) {
+      node = nodes_.acquire();
+      node->data = orderData;
+      link(node);
+
+      return;
+    }
+
+    if (node->data.side == orderData.side && node->data.price == orderData.price &&
+        !(node->data.size < orderData.size)) {
+      node->queue->size += orderData.size - node->data.size;
+      node->data = orderData;
+
+      return;
+    }
+
+    unlink(node);
+    node->data = orderData;
+    link(node);
+  }
+
+  void erase(dxf_long_t index) {
+    auto* found = orders_.find(index);
+
+    if (found == nullptr) return;
+
+    auto* node = *found;
+
+    orders_.erase(index);
+    unlink(node);
+    nodes_.release(node);
+  }
+
+  void clear() {
+    orders_.clear();
+    askQueues_.clear();
+    bidQueues_.clear();
+    nodes_.releaseAll();
+    queues_.releaseAll();
+  }
+
+  void reserve(std::size_t ordersNumber) {
+    orders_.reserve(ordersNumber);
+    nodes_.reserve(ordersNumber);
+  }
+
+  [[nodiscard]] std::size_t size() const { return orders_.size(); }
+
+  // Calls the f(const BasicOrderData<Number>&) for all the orders. The orders of a price are visited in the order of
+  // their arrival, so putting them in the same order restores the queues.
+  template <typename F>
+  void forEach(F&& f) const {
+    auto forEachInQueue = [&f](const Number&, Queue* const& queue) {
+      for (const auto* node = queue->head; node != nullptr; node = node->next) f(node->data);
+    };
+
+    askQueues_.forEach(forEachInQueue);
+    bidQueues_.forEach(forEachInQueue);
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace dxf {
+
+struct PriceLevel {
+  double price = std::numeric_limits<double>::quiet_NaN();
+  double size = std::numeric_limits<double>::quiet_NaN();
+  std::int64_t time = 0;
+
+  friend bool operator<(const PriceLevel& a, const PriceLevel& b) {
+    if (std::isnan(b.price)) return true;
+    if (std::isnan(a.price)) return false;
+
+    return a.price < b.price;
+  }
+};
+
+// The price level with the price and size scaled to integers (see FixedPointPriceLevelNumbers)
+struct FixedPointPriceLevel {
+  std::int64_t price = 0;
+  std::int64_t size = 0;
+  std::int64_t time = 0;
+
+  friend bool operator<(const FixedPointPriceLevel& a, const FixedPointPriceLevel& b) { return a.price < b.price; }
+};
+
+template <typename Level>
+struct BasicPriceLevelChanges {
+  std::vector<Level> asks{};
+  std::vector<Level> bids{};
+};
+
+using PriceLevelChanges = BasicPriceLevelChanges<PriceLevel>;
+
+struct PriceLevelChangesSet {
+  PriceLevelChanges additions{};
+  PriceLevelChanges updates{};
+  PriceLevelChanges removals{};
+};
+
+/*
+ * The price level numbers policies. They define how the prices and sizes of the orders are represented inside the book
+ * and how they are converted back to the PriceLevel at the callback boundary.
+ */
+
+// Prices and sizes are kept as is. Zero sizes are determined with the epsilon.
+struct FloatingPointPriceLevelNumbers {
+  using Number = double;
+  using Level = PriceLevel;
+
+  [[nodiscard]] Number toPrice(double price) const { return price; }
+
+  [[nodiscard]] Number toSize(double size) const { return size; }
+
+  [[nodiscard]] double fromPrice(Number price) const { return price; }
+
+  [[nodiscard]] double fromSize(Number size) const { return size; }
+
+  [[nodiscard]] static bool isZero(Number size) { return std::abs(size) < std::numeric_limits<double>::epsilon(); }
+
+  // All the prices and sizes are representable
+  [[nodiscard]] static bool isValid(double, double) { return true; }
+
+  [[nodiscard]] const PriceLevel& toPriceLevel(const PriceLevel& priceLevel) const { return priceLevel; }
+};
+
+// Prices and sizes are multiplied by the scales and rounded to 64-bit integers once, when the orders enter the book.
+// All the comparisons and the size aggregation are exact.
+//
+// The scaled values are limited by MAX_SCALED (2^62, the headroom for the aggregation): the max price is about 4.6e10
+// with the default priceScale and the max size is about 4.6e12 with the default sizeScale. The book drops the orders
+// with the prices or sizes out of the range (see isValid), the conversions saturate.
+struct FixedPointPriceLevelNumbers {
+  using Number = std::int64_t;
+  using Level = FixedPointPriceLevel;
+
+  static constexpr double MAX_SCALED = 4611686018427387904.0;  // 2^62
+
+  // The price 12.345 is stored as 1234500000 with the priceScale = 100000000
+  std::int64_t priceScale = 100000000;
+  std::int64_t sizeScale = 1000000;
+
+  static Number toScaled(double value, std::int64_t scale) {
+    auto scaled = value * static_cast<double>(scale);
+
+    if (std::isnan(scaled)) return 0;
+
+    return std::llround(std::clamp(scaled, -MAX_SCALED, MAX_SCALED));
+  }
+
+  [[nodiscard]] double getMaxPrice() const { return MAX_SCALED / static_cast<double>(priceScale); }
+
+  [[nodiscard]] double getMaxSize() const { return MAX_SCALED / static_cast<double>(sizeScale); }
+
+  // Returns false if the price or the size is NaN or out of the range
+  [[nodiscard]] bool isValid(double price, double size) const {
+    return std::abs(price) <= getMaxPrice() && std::abs(size) <= getMaxSize();
+  }
+
+  [[nodiscard]] Number toPrice(double price) const { return toScaled(price, priceScale); }
+
+  [[nodiscard]] Number toSize(double size) const { return toScaled(size, sizeScale); }
+
+  [[nodiscard]] double fromPrice(Number price) const {
+    return static_cast<double>(price) / static_cast<double>(priceScale);
+  }
+
+  [[nodiscard]] double fromSize(Number size) const {
+    return static_cast<double>(size) / static_cast<double>(sizeScale);
+  }
+
+  [[nodiscard]] static bool isZero(Number size) { return size == 0; }
+
+  [[nodiscard]] PriceLevel toPriceLevel(const FixedPointPriceLevel& priceLevel) const {
+    return {fromPrice(priceLevel.price), fromSize(priceLevel.size), priceLevel.time};
+  }
+};
+
+}  // namespace dxf
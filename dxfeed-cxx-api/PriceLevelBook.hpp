@@ -1,425 +1,647 @@
 #pragma once
 
 #include <DXFeed.h>
-#include <fmt/format.h>
-
-#include <algorithm>
-#include <boost/multi_index/identity.hpp>
-#include <boost/multi_index/member.hpp>
-#include <boost/multi_index/ordered_index.hpp>
-#include <boost/multi_index/random_access_index.hpp>
-#include <boost/multi_index_container.hpp>
-#include <cassert>
-#include <cmath>
-#include <deque>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
-#include <limits>
 #include <memory>
 #include <mutex>
-#include <set>
+#include <optional>
 #include <string>
+#include <thread>
 #include <utility>
+#include <variant>
 #include <vector>
 
+#include "PriceLevel.hpp"
+#include "PriceLevelBookAnalytics.hpp"
+#include "PriceLevelBookCheckpoint.hpp"
+#include "PriceLevelBookCore.hpp"
+#include "PriceLevelBookHandler.hpp"
+#include "PriceLevelBookQueue.hpp"
+#include "PriceLevelBookView.hpp"
+#include "PriceLevelChangesConflator.hpp"
+#include "PriceLevelLadder.hpp"
+#include "PriceLevelTopPublisher.hpp"
+#include "SharedPriceLevelBooks.hpp"
 #include "StringConverter.hpp"
 
 namespace dxf {
 
-struct OrderData {
-  dxf_long_t index = 0;
-  double price = std::numeric_limits<double>::quiet_NaN();
-  double size = std::numeric_limits<double>::quiet_NaN();
-  dxf_long_t time = 0;
-  dxf_order_side_t side = dxf_osd_undefined;
+enum class PriceLevelNumberType : int {
+  // Prices and sizes are doubles, zero sizes are determined with the epsilon
+  FLOATING_POINT = 0,
+
+  // Prices and sizes are scaled to 64-bit integers when the orders enter the book
+  FIXED_POINT = 1
 };
 
-struct PriceLevel {
-  double price = std::numeric_limits<double>::quiet_NaN();
-  double size = std::numeric_limits<double>::quiet_NaN();
-  std::int64_t time = 0;
+struct PriceLevelBookOptions {
+  // The price levels storage
+  PriceLevelLadderType ladderType = PriceLevelLadderType::ORDERED;
 
-  friend bool operator<(const PriceLevel& a, const PriceLevel& b) {
-    if (std::isnan(b.price)) return true;
-    if (std::isnan(a.price)) return false;
+  // The instrument tick size. It is used by the TICK ladder to map the prices to the array slots.
+  double tickSize = 0.01;
 
-    return a.price < b.price;
-  }
-};
+  // The representation of prices and sizes inside the book
+  PriceLevelNumberType numberType = PriceLevelNumberType::FLOATING_POINT;
 
-struct PriceLevelChanges {
-  std::vector<PriceLevel> asks{};
-  std::vector<PriceLevel> bids{};
-};
+  // The FIXED_POINT scales: the price 12.345 is stored as 1234500000 with the priceScale = 100000000. The orders with
+  // the scaled prices or sizes beyond 2^62 are dropped (see FixedPointPriceLevelNumbers::isValid).
+  std::int64_t priceScale = 100000000;
+  std::int64_t sizeScale = 1000000;
 
-struct PriceLevelChangesSet {
-  PriceLevelChanges additions{};
-  PriceLevelChanges updates{};
-  PriceLevelChanges removals{};
-};
+  // Process the snapshot data (the book building and the handlers) in the book's worker thread. The C API thread only
+  // copies the orders into the queue.
+  bool useWorkerThread = false;
+
+  // The worker queue capacity (orders)
+  std::size_t queueCapacity = 65536;
+
+  // The minimum interval between the book update notifications (0 - notify on every change). When it is set, the
+  // incremental changes are merged and the onIncrementalChange and onBookUpdate handlers are called once per interval
+  // from the book's notifier thread. For example, 50ms limits the rate to 20 notifications per second. It is ignored by
+  // the PriceLevelBookManager.
+  std::chrono::milliseconds notificationInterval{0};
+
+  // The expected number of the orders of the book. The order index is preallocated for it (and for the size of every
+  // new snapshot).
+  std::size_t expectedOrdersNumber = 0;
+
+  // The number of the best levels per side published for the lock-free readers (0 - no publication), see readTop
+  std::size_t publishedLevelsNumber = 0;
+
+  // Keep the per-price FIFO queues of the orders (market-by-order), see getQueuePosition and forEachOrder
+  bool trackOrders = false;
 
-namespace bmi = boost::multi_index;
+  // Accumulate the order changes of the pending transaction (the last order of the incremental update has TX_PENDING)
+  // and apply them at once when it is completed, i.e. one notification per transaction. The new snapshots are complete
+  // when they are delivered, so they are never pending. Otherwise, every snapshot data callback is applied and notified
+  // separately.
+  bool batchTransactions = true;
 
-using PriceLevelContainer = bmi::multi_index_container<
-  PriceLevel,
-  bmi::indexed_by<bmi::random_access<>, bmi::ordered_unique<bmi::member<PriceLevel, double, &PriceLevel::price>>>>;
+  // The checkpoint file (see PriceLevelBook::saveCheckpoint) to restore the book from before the subscription. The
+  // book is empty if the checkpoint is invalid or does not belong to the symbol and source. It is ignored by the
+  // ConsolidatedPriceLevelBook and the PriceLevelBookManager.
+  std::string checkpointPath{};
+};
+
+using PriceLevelBookCoreVariant =
+  std::variant<PriceLevelBookCore<FloatingPointPriceLevelNumbers, OrderedPriceLevelLadder<PriceLevel>>,
+               PriceLevelBookCore<FloatingPointPriceLevelNumbers, TickPriceLevelLadder<PriceLevel>>,
+               PriceLevelBookCore<FixedPointPriceLevelNumbers, OrderedPriceLevelLadder<FixedPointPriceLevel>>,
+               PriceLevelBookCore<FixedPointPriceLevelNumbers, TickPriceLevelLadder<FixedPointPriceLevel>>,
+               PriceLevelBookCore<FloatingPointPriceLevelNumbers, ShallowPriceLevelLadder<PriceLevel>>,
+               PriceLevelBookCore<FixedPointPriceLevelNumbers, ShallowPriceLevelLadder<FixedPointPriceLevel>>>;
+
+class PriceLevelBookManager;
+class ConsolidatedPriceLevelBook;
+
+/*
+ * The price level book of the symbol and source. The book notifies the handler (see PriceLevelBookHandlerTraits) of
+ * the template parameter type, so the hooks are called directly. PriceLevelBook is the book with the std::function
+ * handlers.
+ */
+template <typename Handler>
+class BasicPriceLevelBook final {
+  friend class PriceLevelBookManager;
+  friend class ConsolidatedPriceLevelBook;
+
+  using HandlerTraits = PriceLevelBookHandlerTraits<Handler>;
 
-class PriceLevelBook final {
   dxf_snapshot_t snapshot_;
   std::string symbol_;
   std::string source_;
   std::size_t levelsNumber_;
-  PriceLevelContainer asks_;
-  PriceLevelContainer bids_;
-  std::unordered_map<dxf_long_t, OrderData> orderDataSnapshot_;
+  PriceLevelBookCoreVariant core_;
   bool isValid_;
   std::mutex mutex_;
 
-  std::function<void(const PriceLevelChanges&)> onNewBook_;
-  std::function<void(const PriceLevelChanges&)> onBookUpdate_;
-  std::function<void(const PriceLevelChangesSet&)> onIncrementalChange_;
+  // The transaction is accumulated by the core (see PriceLevelBookOptions::batchTransactions)
+  bool batchTransactions_;
+
+  // The book was restored from a checkpoint: the next new snapshot is notified as the differences from restoredBook_
+  bool isReconciling_;
+  PriceLevelChanges restoredBook_;
+
+  Handler handler_;
+
+  // The handlers' arguments. Their capacity is reused between the notifications.
+  PriceLevelChangesSet changesSet_;
+  PriceLevelChanges book_;
+
+  std::unique_ptr<PriceLevelTopPublisher> topPublisher_;
 
-  static bool isZeroPriceLevel(const PriceLevel& pl) {
-    return std::abs(pl.size) < std::numeric_limits<double>::epsilon();
-  };
+  // The shared memory segment slot of the book (see publishTo)
+  SharedPriceLevelBooksWriter* sharedWriter_;
+  std::size_t sharedSlot_;
+
+  // The book's own queue (with the worker thread) or the queue of the PriceLevelBookManager shard
+  std::unique_ptr<PriceLevelBookQueue> ownQueue_;
+  PriceLevelBookQueue* queue_;
+  std::thread worker_;
+
+  std::chrono::milliseconds notificationInterval_;
+  std::unique_ptr<PriceLevelChangesConflator> conflator_;
+  std::mutex notifierMutex_;
+  std::condition_variable notifierCv_;
+  bool isNotifierStopped_;
+  std::thread notifier_;
+
+  static PriceLevelBookCoreVariant makeCore(std::size_t levelsNumber, const PriceLevelBookOptions& options) {
+    if (options.numberType == PriceLevelNumberType::FIXED_POINT) {
+      auto numbers = FixedPointPriceLevelNumbers{options.priceScale, options.sizeScale};
+
+      if (options.ladderType == PriceLevelLadderType::TICK) {
+        return PriceLevelBookCore<FixedPointPriceLevelNumbers, TickPriceLevelLadder<FixedPointPriceLevel>>{
+          numbers, levelsNumber, options.tickSize, options.trackOrders};
+      }
 
-  static bool areEqualPrices(double price1, double price2) {
-    return std::abs(price1 - price2) < std::numeric_limits<double>::epsilon();
+      if (options.ladderType == PriceLevelLadderType::SHALLOW) {
+        return PriceLevelBookCore<FixedPointPriceLevelNumbers, ShallowPriceLevelLadder<FixedPointPriceLevel>>{
+          numbers, levelsNumber, options.tickSize, options.trackOrders};
+      }
+
+      return PriceLevelBookCore<FixedPointPriceLevelNumbers, OrderedPriceLevelLadder<FixedPointPriceLevel>>{
+        numbers, levelsNumber, options.tickSize, options.trackOrders};
+    }
+
+    if (options.ladderType == PriceLevelLadderType::TICK) {
+      return PriceLevelBookCore<FloatingPointPriceLevelNumbers, TickPriceLevelLadder<PriceLevel>>{
+        FloatingPointPriceLevelNumbers{}, levelsNumber, options.tickSize, options.trackOrders};
+    }
+
+    if (options.ladderType == PriceLevelLadderType::SHALLOW) {
+      return PriceLevelBookCore<FloatingPointPriceLevelNumbers, ShallowPriceLevelLadder<PriceLevel>>{
+        FloatingPointPriceLevelNumbers{}, levelsNumber, options.tickSize, options.trackOrders};
+    }
+
+    return PriceLevelBookCore<FloatingPointPriceLevelNumbers, OrderedPriceLevelLadder<PriceLevel>>{
+      FloatingPointPriceLevelNumbers{}, levelsNumber, options.tickSize, options.trackOrders};
   }
 
-  PriceLevelBook(std::string symbol, std::string source, std::size_t levelsNumber = 0)
+  BasicPriceLevelBook(std::string symbol, std::string source, std::size_t levelsNumber = 0,
+                      const PriceLevelBookOptions& options = {}, Handler handler = {})
       : snapshot_{nullptr},
         symbol_{std::move(symbol)},
         source_{std::move(source)},
         levelsNumber_{levelsNumber},
-        asks_{},
-        bids_{},
-        orderDataSnapshot_{},
+        core_{makeCore(levelsNumber, options)},
         isValid_{false},
-        mutex_{} {}
+        mutex_{},
+        batchTransactions_{options.batchTransactions},
+        isReconciling_{false},
+        restoredBook_{},
+        handler_{std::move(handler)},
+        changesSet_{},
+        book_{},
+        topPublisher_{options.publishedLevelsNumber != 0
+                        ? std::make_unique<PriceLevelTopPublisher>(options.publishedLevelsNumber)
+                        : nullptr},
+        sharedWriter_{nullptr},
+        sharedSlot_{0},
+        ownQueue_{},
+        queue_{nullptr},
+        worker_{},
+        notificationInterval_{options.notificationInterval},
+        conflator_{},
+        notifierMutex_{},
+        notifierCv_{},
+        isNotifierStopped_{false},
+        notifier_{} {
+    std::visit([&options](auto& core) { core.reserveOrders(options.expectedOrdersNumber); }, core_);
+
+    if (!options.checkpointPath.empty()) {
+      restoreCheckpoint(options.checkpointPath);
+    }
 
-  // Process the tx\snapshot data, converts it to PL changes. Also, changes the orderDataSnapshot_
-  PriceLevelChanges convertToUpdates(const dxf_snapshot_data_ptr_t snapshotData) {
-    assert(snapshotData->records_count != 0);
-    assert(snapshotData->event_type != dx_eid_order);
+    if (notificationInterval_.count() > 0) {
+      conflator_ = std::make_unique<PriceLevelChangesConflator>();
+      notifier_ = std::thread([this] { runNotifier(); });
+    }
 
-    std::set<PriceLevel> askUpdates{};
-    std::set<PriceLevel> bidUpdates{};
+    if (options.useWorkerThread) {
+      ownQueue_ = std::make_unique<PriceLevelBookQueue>(options.queueCapacity);
+      queue_ = ownQueue_.get();
+      worker_ = std::thread([this] { runWorker(); });
+    }
+  }
+
+  // Publishes the best levels to the lock-free readers of this and other processes
+  template <typename Core>
+  void publish(const Core& core) {
+    if (!topPublisher_ && sharedWriter_ == nullptr) return;
+
+    auto view = core.getView();
+
+    if (topPublisher_) {
+      topPublisher_->publish(view);
+    }
+
+    if (sharedWriter_ != nullptr) {
+      sharedWriter_->publish(sharedSlot_, view);
+    }
+  }
+
+  // Returns true if the incremental update leaves the transaction pending (TX_PENDING of its last order). The C API
+  // delivers the new snapshot when it is received completely, so its SNAPSHOT_BEGIN, SNAPSHOT_END, SNAPSHOT_SNIP and
+  // TX_PENDING flags are not checked: a snapshot without the closing flag would keep the book pending forever.
+  static bool isTransactionPending(const dxf_snapshot_data_ptr_t snapshotData, bool newSnap) {
+    if (newSnap || snapshotData->records_count == 0) return false;
 
     auto orders = reinterpret_cast<const dxf_order_t*>(snapshotData->records);
 
-    auto isOrderRemoval = [](const dxf_order_t& o) {
-      return (o.event_flags & dxf_ef_remove_event) != 0 || o.size == 0 || std::isnan(o.size);
-    };
+    return (orders[snapshotData->records_count - 1].event_flags & dxf_ef_tx_pending) != 0;
+  }
 
-    auto processOrderAddition = [&bidUpdates, &askUpdates](const dxf_order_t& order) {
-      auto& updatesSide = order.side == dxf_osd_buy ? bidUpdates : askUpdates;
-      auto priceLevelChange = PriceLevel{order.price, order.size, order.time};
-      auto foundPriceLevel = updatesSide.find(priceLevelChange);
+  // Collects the differences between the visible sides (best first)
+  static void diffSide(const std::vector<PriceLevel>& from, const std::vector<PriceLevel>& to, bool isBid,
+                       std::vector<PriceLevel>& additions, std::vector<PriceLevel>& updates,
+                       std::vector<PriceLevel>& removals) {
+    auto isBetter = [isBid](double price1, double price2) { return isBid ? price1 > price2 : price1 < price2; };
+    auto f = from.begin();
+    auto t = to.begin();
+
+    additions.clear();
+    updates.clear();
+    removals.clear();
+
+    while (f != from.end() || t != to.end()) {
+      if (t == to.end() || (f != from.end() && isBetter(f->price, t->price))) {
+        removals.push_back(*f++);
+      } else if (f == from.end() || isBetter(t->price, f->price)) {
+        additions.push_back(*t++);
+      } else {
+        if (f->size != t->size) updates.push_back(*t);
 
-      if (foundPriceLevel != updatesSide.end()) {
-        priceLevelChange.size = foundPriceLevel->size + priceLevelChange.size;
-        updatesSide.erase(foundPriceLevel);
+        ++f;
+        ++t;
       }
+    }
+  }
 
-      updatesSide.insert(priceLevelChange);
-    };
+  [[nodiscard]] static bool isEmpty(const PriceLevelChangesSet& changesSet) {
+    return changesSet.additions.asks.empty() && changesSet.additions.bids.empty() && changesSet.updates.asks.empty() &&
+           changesSet.updates.bids.empty() && changesSet.removals.asks.empty() && changesSet.removals.bids.empty();
+  }
 
-    auto processOrderRemoval = [&bidUpdates, &askUpdates](const dxf_order_t& order, const OrderData& foundOrderData) {
-      auto& updatesSide = foundOrderData.side == dxf_osd_buy ? bidUpdates : askUpdates;
-      auto priceLevelChange = PriceLevel{foundOrderData.price, -foundOrderData.size, order.time};
-      auto foundPriceLevel = updatesSide.find(priceLevelChange);
+  // Notifies the changes (changesSet_) or merges them for the notifier thread
+  template <typename Core>
+  void notifyChanges(Core& core) {
+    if (conflator_) {
+      conflator_->merge(changesSet_);
 
-      if (foundPriceLevel != updatesSide.end()) {
-        priceLevelChange.size = foundPriceLevel->size + priceLevelChange.size;
-        updatesSide.erase(foundPriceLevel);
-      }
+      return;
+    }
+
+    HandlerTraits::notifyUpdate(handler_, core, changesSet_, book_);
+  }
 
-      if (!isZeroPriceLevel(priceLevelChange)) {
-        updatesSide.insert(priceLevelChange);
+  // Notifies the new book. The first new book after the restoration from a checkpoint is notified as the differences
+  // from the restored book.
+  template <typename Core>
+  void notifyNewBook(Core& core) {
+    if (isReconciling_) {
+      isReconciling_ = false;
+      core.copyBook(book_);
+      diffSide(restoredBook_.asks, book_.asks, false, changesSet_.additions.asks, changesSet_.updates.asks,
+               changesSet_.removals.asks);
+      diffSide(restoredBook_.bids, book_.bids, true, changesSet_.additions.bids, changesSet_.updates.bids,
+               changesSet_.removals.bids);
+      restoredBook_ = {};
+
+      if (!isEmpty(changesSet_)) {
+        notifyChanges(core);
       }
-    };
 
-    for (std::size_t i = 0; i < snapshotData->records_count; i++) {
-      auto order = orders[i];
+      return;
+    }
 
-      fmt::print("O:ind={},pr={},sz={},sd={}\n", order.index, order.price, order.size,
-                 order.side == dxf_osd_buy ? "buy" : "sell");
+    HandlerTraits::notifyNewBook(handler_, core, book_);
+  }
 
-      auto removal = isOrderRemoval(order);
-      auto foundOrderDataIt = orderDataSnapshot_.find(order.index);
+  void applySnapshotData(const dxf_snapshot_data_ptr_t snapshotData, bool newSnap) {
+    std::lock_guard<std::mutex> lk(mutex_);
 
-      if (foundOrderDataIt == orderDataSnapshot_.end()) {
-        if (removal) {
-          continue;
-        }
+    std::visit(
+      [this, snapshotData, newSnap](auto& core) {
+        auto version = core.getVersion();
 
-        processOrderAddition(order);
-        orderDataSnapshot_[order.index] = OrderData{order.index, order.price, order.size, order.time, order.side};
-      } else {
-        const auto& foundOrderData = foundOrderDataIt->second;
+        if (newSnap) {
+          // The restored book is kept until the new snapshot is applied
+          if (isReconciling_) {
+            core.copyBook(restoredBook_);
+          }
 
-        if (removal) {
-          processOrderRemoval(order, foundOrderData);
-          orderDataSnapshot_.erase(foundOrderData.index);
-        } else {
-          if (order.side != foundOrderData.side) {
-            processOrderRemoval(order, foundOrderData);
+          // The pending transaction of the previous snapshot is dropped by the core
+          core.clear();
+          core.reserveOrders(snapshotData->records_count);
+
+          if (conflator_) {
+            conflator_->clear();
+          }
+        }
+
+        if (batchTransactions_) {
+          if (snapshotData->records_count != 0) {
+            core.accumulateUpdates(snapshotData);
           }
 
-          processOrderAddition(order);
-          orderDataSnapshot_[foundOrderData.index] =
-            OrderData{order.index, order.price, order.size, order.time, order.side};
+          if (isTransactionPending(snapshotData, newSnap)) return;
         }
-      }
-    }
 
-    return {std::vector<PriceLevel>{askUpdates.begin(), askUpdates.end()},
-            std::vector<PriceLevel>{bidUpdates.rbegin(), bidUpdates.rend()}};
-  }
+        if (snapshotData->records_count == 0 && core.getPendingUpdates().asks.empty() &&
+            core.getPendingUpdates().bids.empty()) {
+          if (newSnap) {
+            publish(core);
 
-  // TODO: price levels number
-  PriceLevelChangesSet applyUpdates(const PriceLevelChanges& priceLevelUpdates) {
-    PriceLevelChanges additions{};
-    PriceLevelChanges updates{};
-    PriceLevelChanges removals{};
+            notifyNewBook(core);
+          }
 
-    // We generate lists of additions, updates, removals
-    for (const auto& updateAsk : priceLevelUpdates.asks) {
-      auto found = std::lower_bound(asks_.begin(), asks_.end(), updateAsk);
+          return;
+        }
 
-      if (found == asks_.end() || !areEqualPrices(found->price, updateAsk.price)) {
-        additions.asks.push_back(updateAsk);
-      } else {
-        auto newPriceLevelChange = *found;
+        if (!batchTransactions_) {
+          core.convertToUpdates(snapshotData);
+        }
+
+        core.applyUpdates(core.getPendingUpdates(), changesSet_);
+        core.clearPendingUpdates();
 
-        newPriceLevelChange.size += updateAsk.size;
-        newPriceLevelChange.time = updateAsk.time;
+        // The readers see the new book before the handlers are called
+        if (core.getVersion() != version) {
+          publish(core);
+        }
 
-        if (isZeroPriceLevel(newPriceLevelChange)) {
-          removals.asks.push_back(*found);
+        if (newSnap) {
+          notifyNewBook(core);
         } else {
-          updates.asks.push_back(newPriceLevelChange);
+          notifyChanges(core);
         }
-      }
+      },
+      core_);
+  }
+
+  // Processes all the queued snapshot data. Returns false if the queue was empty.
+  bool processQueuedSnapshotData() {
+    auto processed = false;
+
+    while (queue_->tryProcess([this](const dxf_snapshot_data_ptr_t snapshotData, bool newSnap, void*) {
+      applySnapshotData(snapshotData, newSnap);
+    })) {
+      processed = true;
     }
 
-    for (const auto& updateBid : priceLevelUpdates.bids) {
-      auto found = std::lower_bound(bids_.begin(), bids_.end(), updateBid);
+    return processed;
+  }
 
-      if (found == bids_.end() || !areEqualPrices(found->price, updateBid.price)) {
-        additions.bids.push_back(updateBid);
-      } else {
-        auto newPriceLevelChange = *found;
+  // Delivers the merged changes and the book accumulated since the previous notification
+  void notifyConflatedChanges() {
+    std::lock_guard<std::mutex> lk(mutex_);
 
-        newPriceLevelChange.size += updateBid.size;
-        newPriceLevelChange.time = updateBid.time;
+    if (conflator_->empty()) return;
 
-        if (isZeroPriceLevel(newPriceLevelChange)) {
-          removals.bids.push_back(*found);
-        } else {
-          updates.bids.push_back(newPriceLevelChange);
-        }
-      }
-    }
+    const auto& changesSet = conflator_->take();
 
-    std::set<PriceLevel> askRemovals{};
-    std::set<PriceLevel> bidRemovals{};
-    std::set<PriceLevel> askAdditions{};
-    std::set<PriceLevel> bidAdditions{};
-    std::set<PriceLevel> askUpdates{};
-    std::set<PriceLevel> bidUpdates{};
+    std::visit([this, &changesSet](auto& core) { HandlerTraits::notifyUpdate(handler_, core, changesSet, book_); },
+               core_);
+  }
 
-    for (const auto& askRemoval : removals.asks) {
-      if (asks_.empty()) continue;
+  void runNotifier() {
+    std::unique_lock<std::mutex> lk(notifierMutex_);
 
-      // Determine what will be the removal given the number of price levels.
-      if (levelsNumber_ == 0 || asks_.size() <= levelsNumber_ || askRemoval.price < asks_[levelsNumber_].price) {
-        askRemovals.insert(askRemoval);
-      }
+    while (!notifierCv_.wait_for(lk, notificationInterval_, [this] { return isNotifierStopped_; })) {
+      lk.unlock();
+      notifyConflatedChanges();
+      lk.lock();
+    }
+  }
 
-      // Determine what will be the shift in price levels after removal.
-      if (levelsNumber_ != 0 && asks_.size() > levelsNumber_ && askRemoval.price < asks_[levelsNumber_].price) {
-        askAdditions.insert(asks_[levelsNumber_]);
-      }
+  // Creates the order snapshot and attaches the listener. Returns false if the snapshot was not created.
+  bool subscribe(dxf_connection_t connection) {
+    auto wSymbol = StringConverter::utf8ToWString(symbol_);
+    dxf_snapshot_t snapshot = nullptr;
 
-      // remove price level by price
-      asks_.get<1>().erase(askRemoval.price);
+    if (dxf_create_order_snapshot(connection, wSymbol.c_str(), source_.c_str(), 0, &snapshot) == DXF_FAILURE) {
+      return false;
     }
 
-    for (const auto& askAddition : additions.asks) {
-      // We determine what will be the addition of the price level, taking into account the possible quantity.
-      if (levelsNumber_ == 0 || asks_.size() < levelsNumber_ || askAddition.price < asks_[levelsNumber_ - 1].price) {
-        askAdditions.insert(askAddition);
-      }
+    snapshot_ = snapshot;
+    isValid_ = true;
 
-      // We determine what will be the shift after adding
-      if (levelsNumber_ != 0 && asks_.size() >= levelsNumber_ && askAddition.price < asks_[levelsNumber_ - 1].price) {
-        const auto& toRemove = asks_[levelsNumber_ - 1];
+    dxf_attach_snapshot_inc_listener(
+      snapshot,
+      [](const dxf_snapshot_data_ptr_t snapshot_data, int new_snapshot, void* user_data) {
+        static_cast<BasicPriceLevelBook*>(user_data)->processSnapshotData(snapshot_data, new_snapshot);
+      },
+      this);
 
-        // We take into account the possibility that the previously added price level will be deleted.
-        if (askAdditions.contains(toRemove)) {
-          askAdditions.erase(toRemove);
-        } else {
-          askRemovals.insert(toRemove);
-        }
-      }
+    return true;
+  }
 
-      asks_.get<1>().insert(askAddition);
+  void unsubscribe() {
+    if (isValid_) {
+      dxf_close_snapshot(snapshot_);
+      isValid_ = false;
     }
+  }
+
+  void runWorker() {
+    while (!queue_->isStopped()) {
+      auto signal = queue_->getSignal();
 
-    for (const auto& askUpdate : updates.asks) {
-      if (levelsNumber_ == 0 || asks_.get<1>().count(askUpdate.price) > 0) {
-        askUpdates.insert(askUpdate);
+      if (!processQueuedSnapshotData()) {
+        queue_->wait(signal);
       }
+    }
+  }
 
-      asks_.get<1>().erase(askUpdate.price);
-      asks_.get<1>().insert(askUpdate);
+ public:
+  void processSnapshotData(const dxf_snapshot_data_ptr_t snapshotData, int newSnapshot) {
+    if (queue_) {
+      queue_->push(snapshotData, newSnapshot != 0, this);
+    } else {
+      applySnapshotData(snapshotData, newSnapshot != 0);
     }
+  }
 
-    for (const auto& bidRemoval : removals.bids) {
-      if (bids_.empty()) continue;
+  ~BasicPriceLevelBook() {
+    unsubscribe();
 
-      // Determine what will be the removal given the number of price levels.
-      if (levelsNumber_ == 0 || bids_.size() <= levelsNumber_ ||
-          bidRemoval.price > bids_[bids_.size() - 1 - levelsNumber_].price) {
-        bidRemovals.insert(bidRemoval);
-      }
+    if (worker_.joinable()) {
+      queue_->stop();
+      worker_.join();
+    }
 
-      // Determine what will be the shift in price levels after removal.
-      if (levelsNumber_ != 0 && bids_.size() > levelsNumber_ &&
-          bidRemoval.price > bids_[bids_.size() - 1 - levelsNumber_].price) {
-        bidAdditions.insert(bids_[bids_.size() - 1 - levelsNumber_]);
+    if (notifier_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lk(notifierMutex_);
+        isNotifierStopped_ = true;
       }
 
-      // remove price level by price
-      bids_.get<1>().erase(bidRemoval.price);
+      notifierCv_.notify_one();
+      notifier_.join();
     }
+  }
 
-    for (const auto& bidAddition : additions.bids) {
-      // We determine what will be the addition of the price level, taking into account the possible quantity.
-      if (levelsNumber_ == 0 || bids_.size() < levelsNumber_ ||
-          bidAddition.price > bids_[bids_.size() - levelsNumber_].price) {
-        bidAdditions.insert(bidAddition);
-      }
+  static std::unique_ptr<BasicPriceLevelBook> create(dxf_connection_t connection, const std::string& symbol,
+                                                     const std::string& source, std::size_t levelsNumber,
+                                                     const PriceLevelBookOptions& options = {}, Handler handler = {}) {
+    auto plb = std::unique_ptr<BasicPriceLevelBook>(
+      new BasicPriceLevelBook(symbol, source, levelsNumber, options, std::move(handler)));
 
-      // We determine what will be the shift after adding
-      if (levelsNumber_ != 0 && bids_.size() >= levelsNumber_ &&
-          bidAddition.price > bids_[bids_.size() - levelsNumber_].price) {
-        const auto& toRemove = bids_[bids_.size() - levelsNumber_];
+    plb->subscribe(connection);
 
-        // We take into account the possibility that the previously added price level will be deleted.
-        if (bidAdditions.contains(toRemove)) {
-          bidAdditions.erase(toRemove);
-        } else {
-          bidRemovals.insert(toRemove);
-        }
-      }
+    return plb;
+  }
 
-      bids_.get<1>().insert(bidAddition);
-    }
+  // The handler. It is called by the thread that processes the snapshot data (see PriceLevelBookOptions), so it must
+  // not be changed while the book is subscribed.
+  [[nodiscard]] Handler& getHandler() { return handler_; }
 
-    for (const auto& bidUpdate : updates.bids) {
-      if (levelsNumber_ == 0 || bids_.get<1>().count(bidUpdate.price) > 0) {
-        bidUpdates.insert(bidUpdate);
-      }
+  // The std::function handlers of the PriceLevelBook (FunctionPriceLevelBookHandler)
+  void setOnNewBook(std::function<void(const PriceLevelChanges&)> onNewBookHandler) {
+    handler_.setOnNewBook(std::move(onNewBookHandler));
+  }
 
-      bids_.get<1>().erase(bidUpdate.price);
-      bids_.get<1>().insert(bidUpdate);
-    }
+  void setOnBookUpdate(std::function<void(const PriceLevelChanges&)> onBookUpdateHandler) {
+    handler_.setOnBookUpdate(std::move(onBookUpdateHandler));
+  }
 
-    return {PriceLevelChanges{std::vector<PriceLevel>{askAdditions.begin(), askAdditions.end()},
-                              std::vector<PriceLevel>{bidAdditions.rbegin(), bidAdditions.rend()}},
-            PriceLevelChanges{std::vector<PriceLevel>{askUpdates.begin(), askUpdates.end()},
-                              std::vector<PriceLevel>{bidUpdates.rbegin(), bidUpdates.rend()}},
-            PriceLevelChanges{std::vector<PriceLevel>{askRemovals.begin(), askRemovals.end()},
-                              std::vector<PriceLevel>{bidRemovals.rbegin(), bidRemovals.rend()}}};
+  void setOnIncrementalChange(std::function<void(const PriceLevelChangesSet&)> onIncrementalChangeHandler) {
+    handler_.setOnIncrementalChange(std::move(onIncrementalChangeHandler));
   }
 
-  [[nodiscard]] std::vector<PriceLevel> getAsks() const {
-    return {asks_.begin(),
-            (levelsNumber_ == 0 || asks_.size() <= levelsNumber_) ? asks_.end() : asks_.begin() + levelsNumber_};
+  // The view based handlers read the visible levels in place instead of the copies passed to the onNewBook and
+  // onBookUpdate handlers. The view is valid only during the call.
+  void setOnNewBookView(std::function<void(const PriceLevelBookView&)> onNewBookViewHandler) {
+    handler_.setOnNewBookView(std::move(onNewBookViewHandler));
   }
 
-  [[nodiscard]] std::vector<PriceLevel> getBids() const {
-    return {bids_.rbegin(),
-            (levelsNumber_ == 0 || bids_.size() <= levelsNumber_) ? bids_.rend() : bids_.rbegin() + levelsNumber_};
+  void setOnBookUpdateView(std::function<void(const PriceLevelBookView&)> onBookUpdateViewHandler) {
+    handler_.setOnBookUpdateView(std::move(onBookUpdateViewHandler));
   }
 
- public:
-  // TODO: move to another thread
-  void processSnapshotData(const dxf_snapshot_data_ptr_t snapshotData, int newSnapshot) {
+  // Calls the reader(const PriceLevelBookView&) with the view of the current visible book. The book is not changed
+  // during the call.
+  template <typename Reader>
+  void withBookView(Reader&& reader) {
     std::lock_guard<std::mutex> lk(mutex_);
 
-    auto newSnap = newSnapshot != 0;
+    std::forward<Reader>(reader)(std::visit([](const auto& core) { return core.getView(); }, core_));
+  }
 
-    if (newSnap) {
-      asks_.clear();
-      bids_.clear();
-      orderDataSnapshot_.clear();
-    }
+  [[nodiscard]] const std::string& getSymbol() const { return symbol_; }
 
-    if (snapshotData->records_count == 0) {
-      if (newSnap && onNewBook_) {
-        onNewBook_({});
-      }
+  [[nodiscard]] const std::string& getSource() const { return source_; }
 
-      return;
-    }
+  // Returns the position of the order in the queue of its price. Returns std::nullopt if there is no such order or
+  // the book does not track the orders (PriceLevelBookOptions::trackOrders).
+  [[nodiscard]] std::optional<OrderQueuePosition> getQueuePosition(dxf_long_t index) {
+    std::lock_guard<std::mutex> lk(mutex_);
 
-    auto updates = convertToUpdates(snapshotData);
-    auto resultingChangesSet = applyUpdates(updates);
+    return std::visit([index](const auto& core) { return core.getQueuePosition(index); }, core_);
+  }
 
-    if (newSnap) {
-      if (onNewBook_) {
-        onNewBook_(PriceLevelChanges{getAsks(), getBids()});
-      }
-    } else {
-      if (onIncrementalChange_) {
-        onIncrementalChange_(resultingChangesSet);
-      }
+  // Calls the f(const OrderData&) for the orders of the price in the order of their arrival. Does nothing if the book
+  // does not track the orders.
+  template <typename F>
+  void forEachOrder(dxf_order_side_t side, double price, F&& f) {
+    std::lock_guard<std::mutex> lk(mutex_);
 
-      if (onBookUpdate_) {
-        onBookUpdate_(PriceLevelChanges{getAsks(), getBids()});
-      }
-    }
+    std::visit([side, price, &f](const auto& core) { core.forEachOrder(side, price, f); }, core_);
   }
 
-  ~PriceLevelBook() {
-    if (isValid_) {
-      dxf_close_price_level_book(snapshot_);
+  // Writes the orders and all the price levels of the book to the checkpoint file (see PriceLevelBookCheckpoint).
+  // Returns false if the file can not be written.
+  bool saveCheckpoint(const std::string& path) {
+    std::optional<PriceLevelBookCheckpoint> checkpoint{};
+
+    {
+      std::lock_guard<std::mutex> lk(mutex_);
+
+      checkpoint = std::visit(
+        [this](const auto& core) { return PriceLevelBookCheckpoint::make(symbol_, source_, core); }, core_);
     }
+
+    return checkpoint && checkpoint->save(path);
   }
 
-  static std::unique_ptr<PriceLevelBook> create(dxf_connection_t connection, const std::string& symbol,
-                                                const std::string& source, std::size_t levelsNumber) {
-    auto plb = std::unique_ptr<PriceLevelBook>(new PriceLevelBook(symbol, source, levelsNumber));
-    auto wSymbol = StringConverter::utf8ToWString(symbol);
-    dxf_snapshot_t snapshot = nullptr;
+  /*
+   * Restores the book from the checkpoint file. The book must not have processed any snapshot data. The restored book
+   * is published to the readers (withBookView, readTop, getAnalytics) but not notified: the next new snapshot is
+   * reconciled with it and only the differences are notified (as the incremental changes instead of the new book).
+   * Returns false if the checkpoint is invalid, belongs to another symbol or source, or the book is not empty.
+   */
+  bool restoreCheckpoint(const std::string& path) {
+    auto checkpoint = PriceLevelBookCheckpoint::load(path);
 
-    dxf_create_order_snapshot(connection, wSymbol.c_str(), source.c_str(), 0, &snapshot);
+    if (!checkpoint || checkpoint->getSymbol() != symbol_ || checkpoint->getSource() != source_) return false;
 
-    dxf_attach_snapshot_inc_listener(
-      snapshot,
-      [](const dxf_snapshot_data_ptr_t snapshot_data, int new_snapshot, void* user_data) {
-        static_cast<PriceLevelBook*>(user_data)->processSnapshotData(snapshot_data, new_snapshot);
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return std::visit(
+      [this, &checkpoint](auto& core) {
+        if (core.getVersion() != 0) return false;
+
+        core.restore(checkpoint->getOrders(), checkpoint->getAsks(), checkpoint->getBids());
+        isReconciling_ = true;
+        publish(core);
+
+        return true;
       },
-      plb.get());
-    plb->isValid_ = true;
+      core_);
+  }
 
-    return plb;
+  // Returns the cumulative depth, the imbalance and the weighted prices of the visible book. They are maintained by the
+  // book, so the call does not scan the levels.
+  [[nodiscard]] PriceLevelBookAnalytics getAnalytics() {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return std::visit([](const auto& core) { return core.getAnalytics(); }, core_);
   }
 
-  void setOnNewBook(std::function<void(const PriceLevelChanges&)> onNewBookHandler) {
-    onNewBook_ = std::move(onNewBookHandler);
+  // Copies the last published best levels (PriceLevelBookOptions::publishedLevelsNumber) without the locks. Can be
+  // called from any thread. Returns false if the book does not publish the levels.
+  bool readTop(PriceLevelTop& to) const {
+    if (!topPublisher_) return false;
+
+    topPublisher_->read(to);
+
+    return true;
   }
 
-  void setOnBookUpdate(std::function<void(const PriceLevelChanges&)> onBookUpdateHandler) {
-    onBookUpdate_ = std::move(onBookUpdateHandler);
+  /*
+   * Publishes the best levels of the book (up to the writer depth) to the shared memory segment on every visible
+   * change, so the other processes on the host read the book instead of building it (see SharedPriceLevelBooksReader).
+   * The book takes a new slot of the segment: the books of one writer must be added by one thread, the writer must
+   * outlive the books. Returns false if the segment is full or the book is already published.
+   */
+  bool publishTo(SharedPriceLevelBooksWriter& writer) {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    if (sharedWriter_ != nullptr) return false;
+
+    auto slot = writer.addBook(symbol_, source_);
+
+    if (slot < 0) return false;
+
+    sharedWriter_ = &writer;
+    sharedSlot_ = static_cast<std::size_t>(slot);
+    std::visit([&writer, slot](const auto& core) { writer.publish(static_cast<std::size_t>(slot), core.getView()); },
+               core_);
+
+    return true;
   }
 
-  void setOnIncrementalChange(std::function<void(const PriceLevelChangesSet&)> onIncrementalChangeHandler) {
-    onIncrementalChange_ = std::move(onIncrementalChangeHandler);
+  // Returns the worker (or the manager shard) queue depth and lag metrics (empty if the book has no worker thread)
+  [[nodiscard]] PriceLevelBookQueueStats getQueueStats() const {
+    return queue_ ? queue_->getStats() : PriceLevelBookQueueStats{};
   }
 };
 
+using PriceLevelBook = BasicPriceLevelBook<FunctionPriceLevelBookHandler>;
+
 }  // namespace dxf
\ No newline at end of file
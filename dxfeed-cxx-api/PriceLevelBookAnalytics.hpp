@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "PriceLevel.hpp"
+
+namespace dxf {
+
+// The aggregates of the visible levels of one side of the book
+struct PriceLevelSideAnalytics {
+  // The number of the visible levels
+  std::size_t levelsNumber = 0;
+
+  // The best level (NaN price and size if the side is empty)
+  PriceLevel best{};
+
+  // The cumulative size of the visible levels
+  double size = 0.0;
+
+  // The sum of price * size of the visible levels
+  double notional = 0.0;
+
+  // The size-weighted average price of the visible levels or NaN if the side is empty
+  [[nodiscard]] double getWeightedPrice() const {
+    return levelsNumber != 0 ? notional / size : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/*
+ * The analytics of the visible book. The book maintains the aggregates incrementally from the visible changes, so they
+ * are read in O(1) and correspond to the book of the same version (see PriceLevelBookView).
+ */
+struct PriceLevelBookAnalytics {
+  std::uint64_t version = 0;
+  PriceLevelSideAnalytics asks{};
+  PriceLevelSideAnalytics bids{};
+
+  // Returns true if there are no visible levels. The NaN results are keyed on the levels numbers, not on the sizes.
+  [[nodiscard]] bool isEmpty() const { return asks.levelsNumber == 0 && bids.levelsNumber == 0; }
+
+  // (bids size - asks size) / (bids size + asks size), in [-1, 1]. NaN if the book is empty.
+  [[nodiscard]] double getImbalance() const {
+    if (isEmpty()) return std::numeric_limits<double>::quiet_NaN();
+
+    return (bids.size - asks.size) / (bids.size + asks.size);
+  }
+
+  // The mid price of the weighted prices of the sides, each weighted by the size of the opposite side (the depth
+  // "microprice"). NaN if any side is empty.
+  [[nodiscard]] double getWeightedMid() const {
+    if (asks.levelsNumber == 0 || bids.levelsNumber == 0) return std::numeric_limits<double>::quiet_NaN();
+
+    return (bids.getWeightedPrice() * asks.size + asks.getWeightedPrice() * bids.size) / (asks.size + bids.size);
+  }
+
+  // The size-weighted average price of all the visible levels. NaN if the book is empty.
+  [[nodiscard]] double getDepthWeightedPrice() const {
+    if (isEmpty()) return std::numeric_limits<double>::quiet_NaN();
+
+    return (bids.notional + asks.notional) / (bids.size + asks.size);
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,269 @@
+#pragma once
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "OrderIndex.hpp"
+#include "PriceLevel.hpp"
+
+namespace dxf {
+
+/*
+ * The checkpoint file layout (the native byte order):
+ *
+ * [PriceLevelBookCheckpointHeader: 128 bytes]
+ * [PriceLevelBookCheckpointOrder x ordersNumber]
+ * [PriceLevelBookCheckpointLevel x asksNumber] (best first)
+ * [PriceLevelBookCheckpointLevel x bidsNumber] (best first)
+ *
+ * All the records have the fixed sizes that are multiples of 8 bytes, so the file can be mapped and the arrays can be
+ * read in place. The checksum covers the records.
+ */
+struct PriceLevelBookCheckpointHeader {
+  char magic[8];
+  std::uint32_t formatVersion;
+  std::uint32_t headerSize;
+  std::uint64_t ordersNumber;
+  std::uint64_t asksNumber;
+  std::uint64_t bidsNumber;
+  std::uint64_t bookVersion;
+  std::uint64_t checksum;
+  std::uint64_t reserved;
+  char symbol[48];
+  char source[16];
+};
+
+struct PriceLevelBookCheckpointOrder {
+  std::int64_t index;
+  double price;
+  double size;
+  std::int64_t time;
+  std::int32_t side;
+  std::uint32_t reserved;
+};
+
+struct PriceLevelBookCheckpointLevel {
+  double price;
+  double size;
+  std::int64_t time;
+};
+
+static_assert(sizeof(PriceLevelBookCheckpointHeader) == 128);
+static_assert(sizeof(PriceLevelBookCheckpointOrder) == 40);
+static_assert(sizeof(PriceLevelBookCheckpointLevel) == 24);
+
+/*
+ * The checkpoint of the book state: the orders and all the price levels (not only the visible ones). The image is kept
+ * in one buffer exactly as it is laid out in the file, so the saving and the loading are the single writes and reads.
+ */
+class PriceLevelBookCheckpoint final {
+  using Header = PriceLevelBookCheckpointHeader;
+  using Order = PriceLevelBookCheckpointOrder;
+  using Level = PriceLevelBookCheckpointLevel;
+
+  // 8-byte words: the records are aligned
+  std::vector<std::uint64_t> data_;
+
+  [[nodiscard]] const std::byte* bytes() const { return reinterpret_cast<const std::byte*>(data_.data()); }
+
+  std::byte* bytes() { return reinterpret_cast<std::byte*>(data_.data()); }
+
+  [[nodiscard]] std::size_t ordersOffset() const { return sizeof(Header); }
+
+  [[nodiscard]] std::size_t asksOffset() const {
+    return ordersOffset() + static_cast<std::size_t>(getHeader().ordersNumber) * sizeof(Order);
+  }
+
+  [[nodiscard]] std::size_t bidsOffset() const {
+    return asksOffset() + static_cast<std::size_t>(getHeader().asksNumber) * sizeof(Level);
+  }
+
+  [[nodiscard]] std::size_t payloadSize() const {
+    return bidsOffset() + static_cast<std::size_t>(getHeader().bidsNumber) * sizeof(Level) - sizeof(Header);
+  }
+
+  static std::size_t imageSize(std::uint64_t ordersNumber, std::uint64_t asksNumber, std::uint64_t bidsNumber) {
+    return sizeof(Header) + static_cast<std::size_t>(ordersNumber) * sizeof(Order) +
+           static_cast<std::size_t>(asksNumber + bidsNumber) * sizeof(Level);
+  }
+
+  void allocate(std::size_t size) { data_.assign((size + sizeof(std::uint64_t) - 1) / sizeof(std::uint64_t), 0); }
+
+  static void writeLevels(const std::vector<PriceLevel>& from, Level* to) {
+    for (const auto& priceLevel : from) *to++ = Level{priceLevel.price, priceLevel.size, priceLevel.time};
+  }
+
+  PriceLevelBookCheckpoint() = default;
+
+ public:
+  static constexpr char MAGIC[8] = {'D', 'X', 'F', 'P', 'L', 'B', 'C', 'P'};
+  static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+  // FNV-1a over the 8-byte words (the size must be a multiple of 8)
+  static std::uint64_t computeChecksum(const std::uint64_t* words, std::size_t wordsNumber) {
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+
+    for (std::size_t i = 0; i < wordsNumber; i++) {
+      hash ^= words[i];
+      hash *= 0x100000001b3ULL;
+    }
+
+    return hash;
+  }
+
+  /*
+   * Makes the checkpoint of the book core (see PriceLevelBookCore::forEachStoredOrder and copyAllLevels). Returns
+   * std::nullopt if the symbol or the source do not fit the header.
+   */
+  template <typename Core>
+  static std::optional<PriceLevelBookCheckpoint> make(const std::string& symbol, const std::string& source,
+                                                      const Core& core) {
+    if (symbol.size() >= sizeof(Header::symbol) || source.size() >= sizeof(Header::source)) return std::nullopt;
+
+    PriceLevelChanges levels{};
+    PriceLevelBookCheckpoint result{};
+
+    core.copyAllLevels(levels);
+    result.allocate(imageSize(core.getOrdersNumber(), levels.asks.size(), levels.bids.size()));
+
+    auto& header = *reinterpret_cast<Header*>(result.bytes());
+
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.formatVersion = FORMAT_VERSION;
+    header.headerSize = sizeof(Header);
+    header.ordersNumber = core.getOrdersNumber();
+    header.asksNumber = levels.asks.size();
+    header.bidsNumber = levels.bids.size();
+    header.bookVersion = core.getVersion();
+    std::memcpy(header.symbol, symbol.c_str(), symbol.size());
+    std::memcpy(header.source, source.c_str(), source.size());
+
+    auto* order = reinterpret_cast<Order*>(result.bytes() + result.ordersOffset());
+
+    core.forEachStoredOrder([&order](const OrderData& orderData) {
+      *order++ = Order{orderData.index, orderData.price, orderData.size, orderData.time,
+                       static_cast<std::int32_t>(orderData.side), 0};
+    });
+
+    writeLevels(levels.asks, reinterpret_cast<Level*>(result.bytes() + result.asksOffset()));
+    writeLevels(levels.bids, reinterpret_cast<Level*>(result.bytes() + result.bidsOffset()));
+
+    header.checksum = computeChecksum(result.data_.data() + sizeof(Header) / sizeof(std::uint64_t),
+                                      result.payloadSize() / sizeof(std::uint64_t));
+
+    return result;
+  }
+
+  // Reads and validates the checkpoint file: the magic, the format version, the size and the checksum.
+  // Returns std::nullopt if the file can not be read or is invalid.
+  static std::optional<PriceLevelBookCheckpoint> load(const std::string& path) {
+    std::unique_ptr<FILE, decltype(&std::fclose)> file{std::fopen(path.c_str(), "rb"), &std::fclose};
+
+    if (!file) return std::nullopt;
+
+    Header header{};
+
+    if (std::fread(&header, sizeof(Header), 1, file.get()) != 1) return std::nullopt;
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.formatVersion != FORMAT_VERSION ||
+        header.headerSize != sizeof(Header) || header.symbol[sizeof(Header::symbol) - 1] != '\0' ||
+        header.source[sizeof(Header::source) - 1] != '\0') {
+      return std::nullopt;
+    }
+
+    // The numbers are checked against the file size before the allocation
+    if (std::fseek(file.get(), 0, SEEK_END) != 0) return std::nullopt;
+
+    auto fileSize = std::ftell(file.get());
+
+    if (fileSize < 0) return std::nullopt;
+
+    auto maxRecordsNumber = static_cast<std::uint64_t>(fileSize) / sizeof(Level);
+
+    if (header.ordersNumber > maxRecordsNumber || header.asksNumber > maxRecordsNumber ||
+        header.bidsNumber > maxRecordsNumber) {
+      return std::nullopt;
+    }
+
+    auto expectedSize = imageSize(header.ordersNumber, header.asksNumber, header.bidsNumber);
+
+    if (static_cast<std::uint64_t>(fileSize) != expectedSize || std::fseek(file.get(), 0, SEEK_SET) != 0) {
+      return std::nullopt;
+    }
+
+    PriceLevelBookCheckpoint result{};
+
+    result.allocate(expectedSize);
+
+    if (std::fread(result.bytes(), 1, expectedSize, file.get()) != expectedSize) return std::nullopt;
+
+    if (computeChecksum(result.data_.data() + sizeof(Header) / sizeof(std::uint64_t),
+                        result.payloadSize() / sizeof(std::uint64_t)) != header.checksum) {
+      return std::nullopt;
+    }
+
+    return result;
+  }
+
+  // Writes the checkpoint to the temporary file `path` + ".tmp" and renames it over the `path`, so the previous
+  // checkpoint is kept if the write fails. Returns false if the file can not be written.
+  [[nodiscard]] bool save(const std::string& path) const {
+    auto tmpPath = path + ".tmp";
+    auto* file = std::fopen(tmpPath.c_str(), "wb");
+
+    if (file == nullptr) return false;
+
+    auto size = payloadSize() + sizeof(Header);
+    auto isWritten = std::fwrite(bytes(), 1, size, file) == size && std::fflush(file) == 0;
+
+    // The buffered data can fail to be written on close too
+    isWritten = std::fclose(file) == 0 && isWritten;
+
+#ifdef _WIN32
+    isWritten = isWritten && MoveFileExA(tmpPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    isWritten = isWritten && std::rename(tmpPath.c_str(), path.c_str()) == 0;
+#endif
+
+    if (!isWritten) {
+      std::remove(tmpPath.c_str());
+    }
+
+    return isWritten;
+  }
+
+  [[nodiscard]] const Header& getHeader() const { return *reinterpret_cast<const Header*>(bytes()); }
+
+  [[nodiscard]] std::string getSymbol() const { return getHeader().symbol; }
+
+  [[nodiscard]] std::string getSource() const { return getHeader().source; }
+
+  [[nodiscard]] std::span<const Order> getOrders() const {
+    return {reinterpret_cast<const Order*>(bytes() + ordersOffset()),
+            static_cast<std::size_t>(getHeader().ordersNumber)};
+  }
+
+  [[nodiscard]] std::span<const Level> getAsks() const {
+    return {reinterpret_cast<const Level*>(bytes() + asksOffset()), static_cast<std::size_t>(getHeader().asksNumber)};
+  }
+
+  [[nodiscard]] std::span<const Level> getBids() const {
+    return {reinterpret_cast<const Level*>(bytes() + bidsOffset()), static_cast<std::size_t>(getHeader().bidsNumber)};
+  }
+};
+
+}  // namespace dxf
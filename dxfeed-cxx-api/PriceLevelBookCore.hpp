@@ -0,0 +1,584 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "OrderIndex.hpp"
+#include "OrderQueueBook.hpp"
+#include "PriceLevel.hpp"
+#include "PriceLevelBookAnalytics.hpp"
+#include "PriceLevelBookTrace.hpp"
+#include "PriceLevelBookView.hpp"
+#include "PriceLevelLadder.hpp"
+
+namespace dxf {
+
+/*
+ * The book state (the orders and the price level ladders) and the book building algorithm.
+ * The orders are kept in the OrderIndex or, when the book tracks the orders (market-by-order), in the OrderQueueBook.
+ * `Numbers` defines the representation of prices and sizes (FloatingPointPriceLevelNumbers or
+ * FixedPointPriceLevelNumbers), `Ladder` defines the price levels storage, `Trace` defines the tracing of the processed
+ * orders (see PriceLevelBookTrace.hpp). The levels are converted to the PriceLevel only when the results are returned.
+ *
+ * The intermediate results are kept in the sorted (best first) vectors owned by the core. They are cleared, but not
+ * released, between the calls, so the processing of the snapshot data does not allocate in the steady state.
+ */
+template <typename Numbers, typename Ladder, typename Trace = DefaultOrderTrace>
+class PriceLevelBookCore final {
+  using Number = typename Numbers::Number;
+  using Level = typename Numbers::Level;
+  using LevelChanges = BasicPriceLevelChanges<Level>;
+
+  // The aggregates of the visible levels of one side (see PriceLevelBookAnalytics)
+  struct SideTotals {
+    Number size{};
+    double notional = 0.0;
+  };
+
+  Numbers numbers_;
+  std::size_t levelsNumber_;
+  Ladder asks_;
+  Ladder bids_;
+  OrderIndex<Number> orderIndex_;
+  std::unique_ptr<OrderQueueBook<Number>> orderQueues_;
+  [[no_unique_address]] Trace trace_;
+  std::uint64_t version_;
+  SideTotals askTotals_;
+  SideTotals bidTotals_;
+
+  // The scratch buffers
+  LevelChanges priceLevelUpdates_;
+  std::vector<Level> additions_;
+  std::vector<Level> updates_;
+  std::vector<Level> removals_;
+  std::vector<Level> sideAdditions_;
+  std::vector<Level> sideUpdates_;
+  std::vector<Level> sideRemovals_;
+  std::vector<Level> levels_;
+
+  // Returns the position of the price level with the price in the vector sorted by the ladder order (best first)
+  static typename std::vector<Level>::iterator lowerBound(const Ladder& ladder, std::vector<Level>& levels,
+                                                          Number price) {
+    return std::lower_bound(levels.begin(), levels.end(), price, [&ladder](const Level& priceLevel, Number p) {
+      return ladder.isBetter(priceLevel.price, p);
+    });
+  }
+
+  static bool contains(const Ladder& ladder, std::vector<Level>& levels, const Level& priceLevel) {
+    auto found = lowerBound(ladder, levels, priceLevel.price);
+
+    return found != levels.end() && found->price == priceLevel.price;
+  }
+
+  // Inserts the price level if there is no price level with the same price
+  static void insert(const Ladder& ladder, std::vector<Level>& levels, const Level& priceLevel) {
+    auto found = lowerBound(ladder, levels, priceLevel.price);
+
+    if (found == levels.end() || found->price != priceLevel.price) {
+      levels.insert(found, priceLevel);
+    }
+  }
+
+  static void erase(const Ladder& ladder, std::vector<Level>& levels, const Level& priceLevel) {
+    auto found = lowerBound(ladder, levels, priceLevel.price);
+
+    if (found != levels.end() && found->price == priceLevel.price) {
+      levels.erase(found);
+    }
+  }
+
+  // Adds the size to the price level with the same price. The price level is removed if the resulting size is zero.
+  static void accumulate(const Ladder& ladder, std::vector<Level>& levels, Level priceLevelChange) {
+    auto found = lowerBound(ladder, levels, priceLevelChange.price);
+
+    if (found != levels.end() && found->price == priceLevelChange.price) {
+      priceLevelChange.size = found->size + priceLevelChange.size;
+
+      if (Numbers::isZero(priceLevelChange.size)) {
+        levels.erase(found);
+      } else {
+        *found = priceLevelChange;
+      }
+    } else if (!Numbers::isZero(priceLevelChange.size)) {
+      levels.insert(found, priceLevelChange);
+    }
+  }
+
+  [[nodiscard]] const Ladder& getLadder(PriceLevelSide side) const {
+    return side == PriceLevelSide::BID ? bids_ : asks_;
+  }
+
+  [[nodiscard]] std::size_t visibleSize(const Ladder& ladder) const {
+    return (levelsNumber_ == 0 || ladder.size() <= levelsNumber_) ? ladder.size() : levelsNumber_;
+  }
+
+  static const PriceLevelBookCore& fromView(const void* book) { return *static_cast<const PriceLevelBookCore*>(book); }
+
+  static constexpr PriceLevelSideView::Accessors VIEW_ACCESSORS{
+    [](const void* book, PriceLevelSide side, std::size_t index) -> PriceLevel {
+      const auto& core = fromView(book);
+
+      return core.numbers_.toPriceLevel(core.getLadder(side)[index]);
+    },
+    [](const void* book, PriceLevelSide side) { return fromView(book).getLadder(side).bestCursor(); },
+    [](const void* book, PriceLevelSide side, std::size_t cursor) {
+      return fromView(book).getLadder(side).nextCursor(cursor);
+    },
+    [](const void* book, PriceLevelSide side, std::size_t cursor) -> PriceLevel {
+      const auto& core = fromView(book);
+
+      return core.numbers_.toPriceLevel(core.getLadder(side).atCursor(cursor));
+    }};
+
+  [[nodiscard]] OrderData toOrderData(const BasicOrderData<Number>& orderData) const {
+    return {orderData.index, numbers_.fromPrice(orderData.price), numbers_.fromSize(orderData.size), orderData.time,
+            orderData.side};
+  }
+
+  // Applies the orders to the order store and accumulates the resulting price level changes
+  template <typename Orders>
+  void processOrders(Orders& orders, const dxf_snapshot_data_ptr_t snapshotData) {
+    auto dxfOrders = reinterpret_cast<const dxf_order_t*>(snapshotData->records);
+
+    // The orders with the prices or sizes that the numbers can not represent are removed too
+    auto isOrderRemoval = [this](const dxf_order_t& o) {
+      return (o.event_flags & dxf_ef_remove_event) != 0 || o.size == 0 || std::isnan(o.size) || std::isnan(o.price) ||
+             !numbers_.isValid(o.price, o.size);
+    };
+
+    auto processPriceLevelChange = [this](dxf_order_side_t side, const Level& priceLevelChange) {
+      if (side == dxf_osd_buy) {
+        accumulate(bids_, priceLevelUpdates_.bids, priceLevelChange);
+      } else {
+        accumulate(asks_, priceLevelUpdates_.asks, priceLevelChange);
+      }
+    };
+
+    for (std::size_t i = 0; i < snapshotData->records_count; i++) {
+      const auto& order = dxfOrders[i];
+
+      if constexpr (Trace::IS_ENABLED) {
+        trace_.trace(order);
+      }
+
+      auto removal = isOrderRemoval(order);
+
+      if (const auto* foundOrderData = orders.find(order.index); foundOrderData != nullptr) {
+        // The order is removed or replaced: its previous contribution is subtracted.
+        processPriceLevelChange(foundOrderData->side, Level{foundOrderData->price, -foundOrderData->size, order.time});
+
+        if (removal) {
+          orders.erase(order.index);
+
+          continue;
+        }
+      } else if (removal) {
+        continue;
+      }
+
+      auto orderData =
+        BasicOrderData<Number>{order.index, numbers_.toPrice(order.price), numbers_.toSize(order.size), order.time,
+                               order.side};
+
+      processPriceLevelChange(orderData.side, Level{orderData.price, orderData.size, orderData.time});
+      orders.put(orderData);
+    }
+  }
+
+  void toPriceLevels(const std::vector<Level>& from, std::vector<PriceLevel>& to) const {
+    if constexpr (std::is_same_v<Level, PriceLevel>) {
+      to.assign(from.begin(), from.end());
+    } else {
+      to.clear();
+      to.reserve(from.size());
+
+      for (const auto& priceLevel : from) to.push_back(numbers_.toPriceLevel(priceLevel));
+    }
+  }
+
+  // Adds the size (it can be negative) at the price to the totals
+  void addToTotals(SideTotals& totals, Number price, Number size) const {
+    totals.size += size;
+    totals.notional += numbers_.fromPrice(price) * numbers_.fromSize(size);
+  }
+
+  [[nodiscard]] PriceLevelSideAnalytics getSideAnalytics(const Ladder& ladder, const SideTotals& totals) const {
+    PriceLevelSideAnalytics result{visibleSize(ladder), {}, numbers_.fromSize(totals.size), totals.notional};
+
+    if (!ladder.empty()) {
+      result.best = numbers_.toPriceLevel(ladder[0]);
+    }
+
+    return result;
+  }
+
+  void copyTop(const Ladder& ladder, std::vector<PriceLevel>& to) {
+    if constexpr (std::is_same_v<Level, PriceLevel>) {
+      ladder.copyTop(levelsNumber_, to);
+    } else {
+      ladder.copyTop(levelsNumber_, levels_);
+      toPriceLevels(levels_, to);
+    }
+  }
+
+  // Applies the price level updates (best first) to the one side of the book and collects the resulting changes taking
+  // into account the price levels number. The totals of the visible levels are changed by the same changes.
+  void applySideUpdates(Ladder& ladder, SideTotals& totals, const std::vector<Level>& priceLevelUpdates,
+                        std::vector<PriceLevel>& resultingAdditions, std::vector<PriceLevel>& resultingUpdates,
+                        std::vector<PriceLevel>& resultingRemovals) {
+    additions_.clear();
+    updates_.clear();
+    removals_.clear();
+
+    // We generate lists of additions, updates, removals
+    for (const auto& priceLevelUpdate : priceLevelUpdates) {
+      const auto* found = ladder.find(priceLevelUpdate.price);
+
+      if (found == nullptr) {
+        additions_.push_back(priceLevelUpdate);
+      } else {
+        auto newPriceLevelChange = *found;
+
+        newPriceLevelChange.size += priceLevelUpdate.size;
+        newPriceLevelChange.time = priceLevelUpdate.time;
+
+        if (Numbers::isZero(newPriceLevelChange.size)) {
+          removals_.push_back(*found);
+        } else {
+          updates_.push_back(newPriceLevelChange);
+        }
+      }
+    }
+
+    sideRemovals_.clear();
+    sideAdditions_.clear();
+    sideUpdates_.clear();
+
+    for (const auto& removal : removals_) {
+      if (ladder.empty()) continue;
+
+      auto isVisibleRemoval = levelsNumber_ != 0 && ladder.size() > levelsNumber_ &&
+                              ladder.isBetter(removal.price, ladder[levelsNumber_].price);
+
+      // Determine what will be the removal given the number of price levels.
+      if (levelsNumber_ == 0 || ladder.size() <= levelsNumber_ || isVisibleRemoval) {
+        // We take into account the possibility that the price level was shifted into the visible part by the previous
+        // removal.
+        if (contains(ladder, sideAdditions_, removal)) {
+          erase(ladder, sideAdditions_, removal);
+        } else {
+          insert(ladder, sideRemovals_, removal);
+        }
+      }
+
+      // Determine what will be the shift in price levels after removal.
+      if (isVisibleRemoval) {
+        insert(ladder, sideAdditions_, ladder[levelsNumber_]);
+      }
+
+      // remove price level by price
+      ladder.erase(removal.price);
+    }
+
+    for (const auto& addition : additions_) {
+      auto isShiftingAddition = levelsNumber_ != 0 && ladder.size() >= levelsNumber_ &&
+                                ladder.isBetter(addition.price, ladder[levelsNumber_ - 1].price);
+
+      // We determine what will be the addition of the price level, taking into account the possible quantity.
+      if (levelsNumber_ == 0 || ladder.size() < levelsNumber_ || isShiftingAddition) {
+        insert(ladder, sideAdditions_, addition);
+      }
+
+      // We determine what will be the shift after adding
+      if (isShiftingAddition) {
+        auto toRemove = ladder[levelsNumber_ - 1];
+
+        // We take into account the possibility that the previously added price level will be deleted.
+        if (contains(ladder, sideAdditions_, toRemove)) {
+          erase(ladder, sideAdditions_, toRemove);
+        } else {
+          insert(ladder, sideRemovals_, toRemove);
+        }
+      }
+
+      ladder.insert(addition);
+    }
+
+    for (const auto& update : updates_) {
+      // Only the updates of the visible price levels are published.
+      if (levelsNumber_ == 0 || ladder.size() <= levelsNumber_ ||
+          !ladder.isBetter(ladder[levelsNumber_ - 1].price, update.price)) {
+        insert(ladder, sideUpdates_, update);
+
+        // The ladder still has the size before the changes: the added (shifted) levels are counted with it
+        addToTotals(totals, update.price, update.size - ladder.find(update.price)->size);
+      }
+
+      ladder.update(update);
+    }
+
+    // The removed levels have the sizes they were visible with
+    for (const auto& addition : sideAdditions_) addToTotals(totals, addition.price, addition.size);
+    for (const auto& removal : sideRemovals_) addToTotals(totals, removal.price, -removal.size);
+
+    // The floating point totals accumulate the rounding errors of the deltas: the empty side starts from the exact zero
+    if (ladder.empty()) {
+      totals = {};
+    }
+
+    toPriceLevels(sideAdditions_, resultingAdditions);
+    toPriceLevels(sideUpdates_, resultingUpdates);
+    toPriceLevels(sideRemovals_, resultingRemovals);
+  }
+
+ public:
+  PriceLevelBookCore(Numbers numbers, std::size_t levelsNumber, double tickSize, bool trackOrders = false)
+      : numbers_{numbers},
+        levelsNumber_{levelsNumber},
+        asks_{makePriceLevelLadder<Ladder>(PriceLevelSide::ASK, numbers.toPrice(tickSize), levelsNumber)},
+        bids_{makePriceLevelLadder<Ladder>(PriceLevelSide::BID, numbers.toPrice(tickSize), levelsNumber)},
+        orderIndex_{},
+        orderQueues_{trackOrders ? std::make_unique<OrderQueueBook<Number>>() : nullptr},
+        trace_{},
+        version_{0},
+        askTotals_{},
+        bidTotals_{},
+        priceLevelUpdates_{},
+        additions_{},
+        updates_{},
+        removals_{},
+        sideAdditions_{},
+        sideUpdates_{},
+        sideRemovals_{},
+        levels_{} {}
+
+  void clear() {
+    asks_.clear();
+    bids_.clear();
+    orderIndex_.clear();
+    clearPendingUpdates();
+    askTotals_ = {};
+    bidTotals_ = {};
+
+    if (orderQueues_) {
+      orderQueues_->clear();
+    }
+
+    version_++;
+  }
+
+  // Preallocates the order store for the `ordersNumber` orders
+  void reserveOrders(std::size_t ordersNumber) {
+    if (orderQueues_) {
+      orderQueues_->reserve(ordersNumber);
+    } else {
+      orderIndex_.reserve(ordersNumber);
+    }
+  }
+
+  // Process the tx\snapshot data, converts it to PL changes (best first). Also, changes the orders.
+  // The result is valid until the next call.
+  const LevelChanges& convertToUpdates(const dxf_snapshot_data_ptr_t snapshotData) {
+    clearPendingUpdates();
+    accumulateUpdates(snapshotData);
+
+    return priceLevelUpdates_;
+  }
+
+  // Process the tx\snapshot data and merges its PL changes with the pending changes of the previous calls, so that a
+  // transaction delivered by several calls is applied at once (see getPendingUpdates). Also, changes the orders.
+  void accumulateUpdates(const dxf_snapshot_data_ptr_t snapshotData) {
+    assert(snapshotData->records_count != 0);
+    assert(snapshotData->event_type != dx_eid_order);
+
+    if (orderQueues_) {
+      processOrders(*orderQueues_, snapshotData);
+    } else {
+      processOrders(orderIndex_, snapshotData);
+    }
+  }
+
+  // Returns the accumulated PL changes (best first)
+  [[nodiscard]] const LevelChanges& getPendingUpdates() const { return priceLevelUpdates_; }
+
+  void clearPendingUpdates() {
+    priceLevelUpdates_.asks.clear();
+    priceLevelUpdates_.bids.clear();
+  }
+
+  // Applies the price level updates and fills the `result` reusing its capacity
+  void applyUpdates(const LevelChanges& priceLevelUpdates, PriceLevelChangesSet& result) {
+    applySideUpdates(asks_, askTotals_, priceLevelUpdates.asks, result.additions.asks, result.updates.asks,
+                     result.removals.asks);
+    applySideUpdates(bids_, bidTotals_, priceLevelUpdates.bids, result.additions.bids, result.updates.bids,
+                     result.removals.bids);
+
+    if (!result.additions.asks.empty() || !result.updates.asks.empty() || !result.removals.asks.empty() ||
+        !result.additions.bids.empty() || !result.updates.bids.empty() || !result.removals.bids.empty()) {
+      version_++;
+    }
+  }
+
+  PriceLevelChangesSet applyUpdates(const LevelChanges& priceLevelUpdates) {
+    PriceLevelChangesSet result{};
+
+    applyUpdates(priceLevelUpdates, result);
+
+    return result;
+  }
+
+  [[nodiscard]] bool isTrackingOrders() const { return orderQueues_ != nullptr; }
+
+  // Returns the position of the order in the queue of its price (the book must track the orders)
+  [[nodiscard]] std::optional<OrderQueuePosition> getQueuePosition(dxf_long_t index) const {
+    if (!orderQueues_) return std::nullopt;
+
+    const auto* node = orderQueues_->findOrder(index);
+
+    if (node == nullptr) return std::nullopt;
+
+    Number sizeAhead{};
+    std::size_t ordersAhead = 0;
+
+    for (const auto* n = node->queue->head; n != node; n = n->next) {
+      sizeAhead += n->data.size;
+      ordersAhead++;
+    }
+
+    return OrderQueuePosition{node->data.side,
+                              numbers_.fromPrice(node->data.price),
+                              ordersAhead,
+                              numbers_.fromSize(sizeAhead),
+                              node->queue->ordersNumber,
+                              numbers_.fromSize(node->queue->size)};
+  }
+
+  // Calls the f(const OrderData&) for the orders of the price in the order of their arrival (the book must track the
+  // orders)
+  template <typename F>
+  void forEachOrder(dxf_order_side_t side, double price, F&& f) const {
+    if (!orderQueues_) return;
+
+    const auto* queue = orderQueues_->findQueue(side, numbers_.toPrice(price));
+
+    if (queue == nullptr) return;
+
+    for (const auto* node = queue->head; node != nullptr; node = node->next) {
+      f(toOrderData(node->data));
+    }
+  }
+
+  [[nodiscard]] std::size_t getOrdersNumber() const {
+    return orderQueues_ ? orderQueues_->size() : orderIndex_.size();
+  }
+
+  // Calls the f(const OrderData&) for all the orders of the book (see OrderIndex::forEach, OrderQueueBook::forEach)
+  template <typename F>
+  void forEachStoredOrder(F&& f) const {
+    auto toOrderDataAndCall = [this, &f](const BasicOrderData<Number>& orderData) { f(toOrderData(orderData)); };
+
+    if (orderQueues_) {
+      orderQueues_->forEach(toOrderDataAndCall);
+    } else {
+      orderIndex_.forEach(toOrderDataAndCall);
+    }
+  }
+
+  // Copies all the price levels (not only the visible ones) to the `to`
+  void copyAllLevels(PriceLevelChanges& to) const {
+    toPriceLevels(asks_.copyTop(0), to.asks);
+    toPriceLevels(bids_.copyTop(0), to.bids);
+  }
+
+  /*
+   * Replaces the book state with the orders and the price levels (best first) of a checkpoint (see
+   * PriceLevelBookCheckpoint). The records must have the index, price, size, time, side (the orders) and the price,
+   * size, time (the levels) fields. The levels are not recomputed from the orders.
+   */
+  template <typename Orders, typename Levels>
+  void restore(const Orders& orders, const Levels& asks, const Levels& bids) {
+    clear();
+    reserveOrders(std::size(orders));
+
+    for (const auto& order : orders) {
+      if (!numbers_.isValid(order.price, order.size)) continue;
+
+      auto orderData =
+        BasicOrderData<Number>{order.index, numbers_.toPrice(order.price), numbers_.toSize(order.size), order.time,
+                               static_cast<dxf_order_side_t>(order.side)};
+
+      if (orderQueues_) {
+        orderQueues_->put(orderData);
+      } else {
+        orderIndex_.put(orderData);
+      }
+    }
+
+    auto restoreLevels = [this](const Levels& levels, Ladder& ladder, SideTotals& totals) {
+      for (const auto& priceLevel : levels) {
+        if (!numbers_.isValid(priceLevel.price, priceLevel.size)) continue;
+
+        auto level = Level{numbers_.toPrice(priceLevel.price), numbers_.toSize(priceLevel.size), priceLevel.time};
+
+        ladder.insert(level);
+
+        // The visible levels are the first ones
+        if (levelsNumber_ == 0 || ladder.size() <= levelsNumber_) {
+          addToTotals(totals, level.price, level.size);
+        }
+      }
+    };
+
+    restoreLevels(asks, asks_, askTotals_);
+    restoreLevels(bids, bids_, bidTotals_);
+    version_++;
+  }
+
+  // The version of the visible book: it is increased by every visible change and by every clear
+  [[nodiscard]] std::uint64_t getVersion() const { return version_; }
+
+  // Returns the analytics of the visible book, O(1)
+  [[nodiscard]] PriceLevelBookAnalytics getAnalytics() const {
+    return {version_, getSideAnalytics(asks_, askTotals_), getSideAnalytics(bids_, bidTotals_)};
+  }
+
+  // Returns the view of the visible book. It is valid until the next change of the book.
+  [[nodiscard]] PriceLevelBookView getView() const {
+    return {version_, PriceLevelSideView{this, &VIEW_ACCESSORS, PriceLevelSide::ASK, visibleSize(asks_)},
+            PriceLevelSideView{this, &VIEW_ACCESSORS, PriceLevelSide::BID, visibleSize(bids_)}};
+  }
+
+  // Copies the visible book to the `to` reusing its capacity
+  void copyBook(PriceLevelChanges& to) {
+    copyTop(asks_, to.asks);
+    copyTop(bids_, to.bids);
+  }
+
+  [[nodiscard]] std::vector<PriceLevel> getAsks() const {
+    std::vector<PriceLevel> result{};
+
+    toPriceLevels(asks_.copyTop(levelsNumber_), result);
+
+    return result;
+  }
+
+  [[nodiscard]] std::vector<PriceLevel> getBids() const {
+    std::vector<PriceLevel> result{};
+
+    toPriceLevels(bids_.copyTop(levelsNumber_), result);
+
+    return result;
+  }
+};
+
+}  // namespace dxf
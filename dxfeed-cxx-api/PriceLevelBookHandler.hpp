@@ -0,0 +1,167 @@
+#pragma once
+
+#include <functional>
+#include <utility>
+
+#include "PriceLevel.hpp"
+#include "PriceLevelBookView.hpp"
+
+namespace dxf {
+
+enum class PriceLevelBookHook : int {
+  NEW_BOOK = 0,
+  BOOK_UPDATE = 1,
+  INCREMENTAL_CHANGE = 2,
+  NEW_BOOK_VIEW = 3,
+  BOOK_UPDATE_VIEW = 4
+};
+
+/*
+ * The hooks of the BasicPriceLevelBook handler. The handler is a type with any of the (static or non-static) members:
+ *
+ *   void onNewBook(const PriceLevelChanges& book);
+ *   void onBookUpdate(const PriceLevelChanges& book);
+ *   void onIncrementalChange(const PriceLevelChangesSet& changesSet);
+ *   void onNewBookView(const PriceLevelBookView& view);
+ *   void onBookUpdateView(const PriceLevelBookView& view);
+ *   bool isEnabled(PriceLevelBookHook hook) const; // optional, all the present hooks are enabled without it
+ *
+ * The hooks are called directly (they can be inlined into the book), the missing hooks cost nothing: the book does not
+ * even copy the levels for them.
+ */
+template <typename Handler>
+struct PriceLevelBookHandlerTraits {
+  static constexpr bool HAS_ON_NEW_BOOK = requires(Handler& handler, const PriceLevelChanges& book) {
+    handler.onNewBook(book);
+  };
+
+  static constexpr bool HAS_ON_BOOK_UPDATE = requires(Handler& handler, const PriceLevelChanges& book) {
+    handler.onBookUpdate(book);
+  };
+
+  static constexpr bool HAS_ON_INCREMENTAL_CHANGE = requires(Handler& handler, const PriceLevelChangesSet& changesSet) {
+    handler.onIncrementalChange(changesSet);
+  };
+
+  static constexpr bool HAS_ON_NEW_BOOK_VIEW = requires(Handler& handler, const PriceLevelBookView& view) {
+    handler.onNewBookView(view);
+  };
+
+  static constexpr bool HAS_ON_BOOK_UPDATE_VIEW = requires(Handler& handler, const PriceLevelBookView& view) {
+    handler.onBookUpdateView(view);
+  };
+
+  static bool isEnabled(const Handler& handler, PriceLevelBookHook hook) {
+    if constexpr (requires { handler.isEnabled(hook); }) {
+      return handler.isEnabled(hook);
+    } else {
+      return true;
+    }
+  }
+
+  // Calls the new book hooks. `book` - the buffer of the copy of the visible book (see PriceLevelBookCore::copyBook).
+  template <typename Core>
+  static void notifyNewBook(Handler& handler, Core& core, PriceLevelChanges& book) {
+    if constexpr (HAS_ON_NEW_BOOK) {
+      if (isEnabled(handler, PriceLevelBookHook::NEW_BOOK)) {
+        core.copyBook(book);
+        handler.onNewBook(book);
+      }
+    }
+
+    if constexpr (HAS_ON_NEW_BOOK_VIEW) {
+      if (isEnabled(handler, PriceLevelBookHook::NEW_BOOK_VIEW)) {
+        handler.onNewBookView(core.getView());
+      }
+    }
+  }
+
+  // Calls the update hooks
+  template <typename Core>
+  static void notifyUpdate(Handler& handler, Core& core, const PriceLevelChangesSet& changesSet,
+                           PriceLevelChanges& book) {
+    if constexpr (HAS_ON_INCREMENTAL_CHANGE) {
+      if (isEnabled(handler, PriceLevelBookHook::INCREMENTAL_CHANGE)) {
+        handler.onIncrementalChange(changesSet);
+      }
+    }
+
+    if constexpr (HAS_ON_BOOK_UPDATE) {
+      if (isEnabled(handler, PriceLevelBookHook::BOOK_UPDATE)) {
+        core.copyBook(book);
+        handler.onBookUpdate(book);
+      }
+    }
+
+    if constexpr (HAS_ON_BOOK_UPDATE_VIEW) {
+      if (isEnabled(handler, PriceLevelBookHook::BOOK_UPDATE_VIEW)) {
+        handler.onBookUpdateView(core.getView());
+      }
+    }
+  }
+};
+
+// The handler without the hooks: the book is read with withBookView, readTop or publishTo
+struct EmptyPriceLevelBookHandler {};
+
+// The handler that calls the std::function handlers (see PriceLevelBook::setOnNewBook etc.)
+class FunctionPriceLevelBookHandler final {
+  std::function<void(const PriceLevelChanges&)> onNewBook_;
+  std::function<void(const PriceLevelChanges&)> onBookUpdate_;
+  std::function<void(const PriceLevelChangesSet&)> onIncrementalChange_;
+  std::function<void(const PriceLevelBookView&)> onNewBookView_;
+  std::function<void(const PriceLevelBookView&)> onBookUpdateView_;
+
+ public:
+  FunctionPriceLevelBookHandler()
+      : onNewBook_{}, onBookUpdate_{}, onIncrementalChange_{}, onNewBookView_{}, onBookUpdateView_{} {}
+
+  [[nodiscard]] bool isEnabled(PriceLevelBookHook hook) const {
+    switch (hook) {
+      case PriceLevelBookHook::NEW_BOOK:
+        return static_cast<bool>(onNewBook_);
+      case PriceLevelBookHook::BOOK_UPDATE:
+        return static_cast<bool>(onBookUpdate_);
+      case PriceLevelBookHook::INCREMENTAL_CHANGE:
+        return static_cast<bool>(onIncrementalChange_);
+      case PriceLevelBookHook::NEW_BOOK_VIEW:
+        return static_cast<bool>(onNewBookView_);
+      case PriceLevelBookHook::BOOK_UPDATE_VIEW:
+        return static_cast<bool>(onBookUpdateView_);
+    }
+
+    return false;
+  }
+
+  void onNewBook(const PriceLevelChanges& book) { onNewBook_(book); }
+
+  void onBookUpdate(const PriceLevelChanges& book) { onBookUpdate_(book); }
+
+  void onIncrementalChange(const PriceLevelChangesSet& changesSet) { onIncrementalChange_(changesSet); }
+
+  void onNewBookView(const PriceLevelBookView& view) { onNewBookView_(view); }
+
+  void onBookUpdateView(const PriceLevelBookView& view) { onBookUpdateView_(view); }
+
+  void setOnNewBook(std::function<void(const PriceLevelChanges&)> onNewBookHandler) {
+    onNewBook_ = std::move(onNewBookHandler);
+  }
+
+  void setOnBookUpdate(std::function<void(const PriceLevelChanges&)> onBookUpdateHandler) {
+    onBookUpdate_ = std::move(onBookUpdateHandler);
+  }
+
+  void setOnIncrementalChange(std::function<void(const PriceLevelChangesSet&)> onIncrementalChangeHandler) {
+    onIncrementalChange_ = std::move(onIncrementalChangeHandler);
+  }
+
+  void setOnNewBookView(std::function<void(const PriceLevelBookView&)> onNewBookViewHandler) {
+    onNewBookView_ = std::move(onNewBookViewHandler);
+  }
+
+  void setOnBookUpdateView(std::function<void(const PriceLevelBookView&)> onBookUpdateViewHandler) {
+    onBookUpdateView_ = std::move(onBookUpdateViewHandler);
+  }
+};
+
+}  // namespace dxf
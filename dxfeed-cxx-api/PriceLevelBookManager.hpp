@@ -0,0 +1,282 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "PriceLevelBook.hpp"
+#include "PriceLevelBookQueue.hpp"
+
+namespace dxf {
+
+struct PriceLevelBookKey {
+  std::string symbol;
+  std::string source;
+};
+
+struct PriceLevelBookManagerOptions {
+  // The number of the worker shards (0 - the number of the hardware threads)
+  std::size_t shardsNumber = 0;
+
+  // Pin the shard workers to the cores firstCore, firstCore + 1, ... (Windows and Linux only)
+  bool pinShards = false;
+  std::size_t firstCore = 0;
+
+  // The shard queue capacity (orders)
+  std::size_t queueCapacity = 65536;
+
+  // The subscription throttle: addBooks sleeps for subscriptionThrottleInterval after every subscriptionThrottleSize
+  // created snapshots, so that the subscription of thousands of books does not flood the connection (0 - no throttle).
+  // The snapshots are still created one by one.
+  std::size_t subscriptionThrottleSize = 100;
+  std::chrono::milliseconds subscriptionThrottleInterval{10};
+
+  // The price levels number of the books (0 - all levels)
+  std::size_t levelsNumber = 0;
+
+  // The options of the books. The useWorkerThread option is ignored: the books are processed by the shards. The
+  // notificationInterval option is ignored too (the books are notified on every change): the conflation would start
+  // the notifier thread per book. The checkpointPath option is ignored: a checkpoint belongs to one book (see
+  // PriceLevelBook::restoreCheckpoint).
+  PriceLevelBookOptions bookOptions{};
+};
+
+struct PriceLevelBookShardStats {
+  std::size_t booksNumber = 0;
+  std::uint64_t processedOrders = 0;
+
+  // The time spent on the processing of the snapshot data (the book building and the handlers)
+  std::chrono::nanoseconds busyTime{};
+
+  PriceLevelBookQueueStats queue{};
+};
+
+struct PriceLevelBookManagerStats {
+  std::size_t booksNumber = 0;
+  std::uint64_t processedBatches = 0;
+  std::uint64_t processedOrders = 0;
+  std::chrono::nanoseconds maxLag{};
+  std::vector<PriceLevelBookShardStats> shards{};
+};
+
+/*
+ * Owns the books of many symbols and sources on one connection. Each book is assigned to a shard by the hash of its
+ * symbol and source. The C API thread only copies the snapshot data into the shard queues, the shard workers build the
+ * books and call the handlers, so the book maintenance scales with the number of the shards.
+ *
+ * The books live as long as the manager. Their handlers are called by the shard workers.
+ * The shard queues have one producer: the snapshot data of all the books must be delivered by one thread (the thread
+ * of the connection).
+ */
+class PriceLevelBookManager final {
+  struct Shard {
+    PriceLevelBookQueue queue;
+    std::thread worker;
+    std::atomic<std::size_t> booksNumber;
+    std::atomic<std::uint64_t> processedOrders;
+    std::atomic<std::int64_t> busyTime;
+
+    explicit Shard(std::size_t queueCapacity)
+        : queue{queueCapacity}, worker{}, booksNumber{0}, processedOrders{0}, busyTime{0} {}
+
+    // Returns false if the queue was empty
+    bool process() {
+      auto processed = false;
+
+      while (queue.tryProcess([this](const dxf_snapshot_data_ptr_t snapshotData, bool newSnap, void* target) {
+        auto start = std::chrono::steady_clock::now();
+
+        static_cast<PriceLevelBook*>(target)->applySnapshotData(snapshotData, newSnap);
+
+        busyTime.fetch_add(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count(),
+          std::memory_order_relaxed);
+        processedOrders.fetch_add(snapshotData->records_count, std::memory_order_relaxed);
+      })) {
+        processed = true;
+      }
+
+      return processed;
+    }
+
+    void run() {
+      while (!queue.isStopped()) {
+        auto signal = queue.getSignal();
+
+        if (!process()) {
+          queue.wait(signal);
+        }
+      }
+    }
+  };
+
+  dxf_connection_t connection_;
+  PriceLevelBookManagerOptions options_;
+  std::vector<std::unique_ptr<Shard>> shards_;
+
+  mutable std::mutex booksMutex_;
+  std::vector<std::unique_ptr<PriceLevelBook>> books_;
+  std::unordered_map<std::string, PriceLevelBook*> booksByKey_;
+
+  static std::string toKey(const std::string& symbol, const std::string& source) { return symbol + '\0' + source; }
+
+  static void pinToCore(std::thread& thread, std::size_t core) {
+#ifdef _WIN32
+    SetThreadAffinityMask(thread.native_handle(), DWORD_PTR{1} << (core % (sizeof(DWORD_PTR) * 8)));
+#elif defined(__linux__)
+    cpu_set_t cpuSet;
+
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core % CPU_SETSIZE, &cpuSet);
+    pthread_setaffinity_np(thread.native_handle(), sizeof(cpu_set_t), &cpuSet);
+#else
+    (void)thread;
+    (void)core;
+#endif
+  }
+
+  PriceLevelBookManager(dxf_connection_t connection, const PriceLevelBookManagerOptions& options)
+      : connection_{connection}, options_{options}, shards_{}, booksMutex_{}, books_{}, booksByKey_{} {
+    auto shardsNumber = options_.shardsNumber != 0 ? options_.shardsNumber
+                                                   : (std::max)(std::thread::hardware_concurrency(), 1U);
+
+    options_.bookOptions.useWorkerThread = false;
+    options_.bookOptions.notificationInterval = std::chrono::milliseconds{0};
+    options_.bookOptions.checkpointPath.clear();
+    shards_.reserve(shardsNumber);
+
+    for (std::size_t i = 0; i < shardsNumber; i++) {
+      auto shard = std::make_unique<Shard>(options_.queueCapacity);
+
+      shard->worker = std::thread([s = shard.get()] { s->run(); });
+
+      if (options_.pinShards) {
+        pinToCore(shard->worker, options_.firstCore + i);
+      }
+
+      shards_.push_back(std::move(shard));
+    }
+  }
+
+ public:
+  static std::unique_ptr<PriceLevelBookManager> create(dxf_connection_t connection,
+                                                       const PriceLevelBookManagerOptions& options = {}) {
+    return std::unique_ptr<PriceLevelBookManager>(new PriceLevelBookManager(connection, options));
+  }
+
+  PriceLevelBookManager(const PriceLevelBookManager&) = delete;
+  PriceLevelBookManager& operator=(const PriceLevelBookManager&) = delete;
+
+  ~PriceLevelBookManager() {
+    // No new snapshot data after this point
+    for (auto& book : books_) {
+      book->unsubscribe();
+    }
+
+    for (auto& shard : shards_) {
+      shard->queue.stop();
+      shard->worker.join();
+    }
+  }
+
+  /*
+   * Creates the books and subscribes them with the subscription throttle (see PriceLevelBookManagerOptions). The
+   * `setUp` is called for every new book before the subscription (to set the handlers). The keys of the existing books
+   * are skipped.
+   * Returns the number of the books that were not subscribed.
+   */
+  std::size_t addBooks(const std::vector<PriceLevelBookKey>& keys,
+                       const std::function<void(PriceLevelBook&)>& setUp = {}) {
+    std::size_t failures = 0;
+    std::size_t subscribedSincePause = 0;
+
+    for (const auto& key : keys) {
+      PriceLevelBook* book = nullptr;
+
+      {
+        std::lock_guard<std::mutex> lk(booksMutex_);
+        auto stringKey = toKey(key.symbol, key.source);
+
+        if (booksByKey_.contains(stringKey)) continue;
+
+        auto& shard = *shards_[std::hash<std::string>{}(stringKey) % shards_.size()];
+
+        books_.push_back(std::unique_ptr<PriceLevelBook>(
+          new PriceLevelBook(key.symbol, key.source, options_.levelsNumber, options_.bookOptions)));
+        book = books_.back().get();
+        book->queue_ = &shard.queue;
+        booksByKey_[stringKey] = book;
+        shard.booksNumber.fetch_add(1, std::memory_order_relaxed);
+      }
+
+      if (setUp) {
+        setUp(*book);
+      }
+
+      if (!book->subscribe(connection_)) {
+        failures++;
+      }
+
+      if (options_.subscriptionThrottleSize != 0 && ++subscribedSincePause == options_.subscriptionThrottleSize) {
+        subscribedSincePause = 0;
+        std::this_thread::sleep_for(options_.subscriptionThrottleInterval);
+      }
+    }
+
+    return failures;
+  }
+
+  // Returns the book or nullptr
+  [[nodiscard]] PriceLevelBook* getBook(const std::string& symbol, const std::string& source) const {
+    std::lock_guard<std::mutex> lk(booksMutex_);
+    auto found = booksByKey_.find(toKey(symbol, source));
+
+    return found == booksByKey_.end() ? nullptr : found->second;
+  }
+
+  [[nodiscard]] std::size_t getShardsNumber() const { return shards_.size(); }
+
+  [[nodiscard]] PriceLevelBookManagerStats getStats() const {
+    PriceLevelBookManagerStats result{};
+
+    result.shards.reserve(shards_.size());
+
+    for (const auto& shard : shards_) {
+      PriceLevelBookShardStats shardStats{shard->booksNumber.load(std::memory_order_relaxed),
+                                          shard->processedOrders.load(std::memory_order_relaxed),
+                                          std::chrono::nanoseconds{shard->busyTime.load(std::memory_order_relaxed)},
+                                          shard->queue.getStats()};
+
+      result.booksNumber += shardStats.booksNumber;
+      result.processedBatches += shardStats.queue.processedBatches;
+      result.processedOrders += shardStats.processedOrders;
+      result.maxLag = (std::max)(result.maxLag, shardStats.queue.maxLag);
+      result.shards.push_back(shardStats);
+    }
+
+    return result;
+  }
+};
+
+}  // namespace dxf
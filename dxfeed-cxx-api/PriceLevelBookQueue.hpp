@@ -0,0 +1,199 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+#include <vector>
+
+#include "SpscRing.hpp"
+
+namespace dxf {
+
+struct PriceLevelBookQueueStats {
+  // The number of queued orders
+  std::size_t depth = 0;
+  std::size_t maxDepth = 0;
+  std::size_t capacity = 0;
+
+  std::uint64_t enqueuedBatches = 0;
+  std::uint64_t processedBatches = 0;
+
+  // The number of times the producer (the C API thread) had to wait for free space
+  std::uint64_t producerWaits = 0;
+
+  // The time between enqueuing the snapshot data and the start of its processing
+  std::chrono::nanoseconds lastLag{};
+  std::chrono::nanoseconds maxLag{};
+};
+
+/*
+ * The queue between the C API thread (the producer) and the book worker (the consumer). The producer copies the
+ * snapshot data records into the preallocated rings: the batch header goes first, then the orders. A batch can be
+ * larger than the queue: the consumer takes the orders as they arrive. The batch carries the opaque target (the book)
+ * so that one queue can serve several books.
+ *
+ * Only the numeric fields of the queued orders are valid, the string pointers may be dangling.
+ */
+class PriceLevelBookQueue final {
+  struct Batch {
+    std::size_t ordersCount;
+    bool isNewSnapshot;
+    std::int64_t enqueueTime;
+    void* target;
+  };
+
+  SpscRing<Batch> batches_;
+  SpscRing<dxf_order_t> orders_;
+  std::atomic<std::uint32_t> signal_;
+  std::atomic<bool> isStopped_;
+
+  // The initial capacity of the batch buffer (orders): the incremental batches are small, the buffer grows to the
+  // largest batch (snapshot) on demand and keeps the capacity
+  static constexpr std::size_t INITIAL_BATCH_CAPACITY = 256;
+
+  // The consumer side buffer of the current batch
+  std::vector<dxf_order_t> batchOrders_;
+
+  std::atomic<std::size_t> maxDepth_;
+  std::atomic<std::uint64_t> enqueuedBatches_;
+  std::atomic<std::uint64_t> processedBatches_;
+  std::atomic<std::uint64_t> producerWaits_;
+  std::atomic<std::int64_t> lastLag_;
+  std::atomic<std::int64_t> maxLag_;
+
+  static std::int64_t now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+  }
+
+  void notify() {
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_one();
+  }
+
+  // Pushes the value, waits while the ring is full. Returns false if the queue was stopped.
+  template <typename T>
+  bool push(SpscRing<T>& ring, const T& value) {
+    if (ring.tryPush(value)) return true;
+
+    producerWaits_.fetch_add(1, std::memory_order_relaxed);
+
+    // The consumer may be waiting for the end of the batch that does not fit into the queue
+    notify();
+
+    while (!ring.tryPush(value)) {
+      if (isStopped_.load(std::memory_order_acquire)) return false;
+
+      std::this_thread::yield();
+    }
+
+    return true;
+  }
+
+ public:
+  explicit PriceLevelBookQueue(std::size_t capacity)
+      : batches_{capacity},
+        orders_{capacity},
+        signal_{0},
+        isStopped_{false},
+        batchOrders_{},
+        maxDepth_{0},
+        enqueuedBatches_{0},
+        processedBatches_{0},
+        producerWaits_{0},
+        lastLag_{0},
+        maxLag_{0} {
+    batchOrders_.reserve((std::min)(INITIAL_BATCH_CAPACITY, orders_.capacity()));
+  }
+
+  // Producer side. Copies the snapshot data records.
+  void push(const dxf_snapshot_data_ptr_t snapshotData, bool isNewSnapshot, void* target = nullptr) {
+    auto orders = reinterpret_cast<const dxf_order_t*>(snapshotData->records);
+
+    if (!push(batches_, Batch{snapshotData->records_count, isNewSnapshot, now(), target})) return;
+
+    for (std::size_t i = 0; i < snapshotData->records_count; i++) {
+      if (!push(orders_, orders[i])) return;
+    }
+
+    enqueuedBatches_.fetch_add(1, std::memory_order_relaxed);
+
+    auto depth = orders_.size();
+
+    if (depth > maxDepth_.load(std::memory_order_relaxed)) {
+      maxDepth_.store(depth, std::memory_order_relaxed);
+    }
+
+    notify();
+  }
+
+  // Consumer side. Pops the next batch and calls the processor(const dxf_snapshot_data_ptr_t, bool isNewSnapshot,
+  // void* target). Returns false if there is no batch.
+  template <typename Processor>
+  bool tryProcess(Processor&& processor) {
+    Batch batch{};
+
+    if (!batches_.tryPop(batch)) return false;
+
+    auto lag = now() - batch.enqueueTime;
+
+    lastLag_.store(lag, std::memory_order_relaxed);
+
+    if (lag > maxLag_.load(std::memory_order_relaxed)) {
+      maxLag_.store(lag, std::memory_order_relaxed);
+    }
+
+    batchOrders_.resize(batch.ordersCount);
+
+    for (std::size_t i = 0; i < batch.ordersCount;) {
+      if (orders_.tryPop(batchOrders_[i])) {
+        i++;
+      } else if (isStopped_.load(std::memory_order_acquire)) {
+        return false;
+      } else {
+        std::this_thread::yield();
+      }
+    }
+
+    dxf_snapshot_data_t snapshotData{};
+
+    snapshotData.event_type = DXF_ET_ORDER;
+    snapshotData.records_count = batch.ordersCount;
+    snapshotData.records = batchOrders_.data();
+
+    processor(&snapshotData, batch.isNewSnapshot, batch.target);
+    processedBatches_.fetch_add(1, std::memory_order_relaxed);
+
+    return true;
+  }
+
+  // The consumer reads the signal before checking the queue and waits on it if the queue was empty.
+  [[nodiscard]] std::uint32_t getSignal() const { return signal_.load(std::memory_order_acquire); }
+
+  void wait(std::uint32_t signal) const { signal_.wait(signal, std::memory_order_acquire); }
+
+  void stop() {
+    isStopped_.store(true, std::memory_order_release);
+    signal_.fetch_add(1, std::memory_order_release);
+    signal_.notify_all();
+  }
+
+  [[nodiscard]] bool isStopped() const { return isStopped_.load(std::memory_order_acquire); }
+
+  [[nodiscard]] PriceLevelBookQueueStats getStats() const {
+    return {orders_.size(),
+            maxDepth_.load(std::memory_order_relaxed),
+            orders_.capacity(),
+            enqueuedBatches_.load(std::memory_order_relaxed),
+            processedBatches_.load(std::memory_order_relaxed),
+            producerWaits_.load(std::memory_order_relaxed),
+            std::chrono::nanoseconds{lastLag_.load(std::memory_order_relaxed)},
+            std::chrono::nanoseconds{maxLag_.load(std::memory_order_relaxed)}};
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <DXFeed.h>
+#include <fmt/format.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <thread>
+
+#include "SpscRing.hpp"
+
+namespace dxf {
+
+/*
+ * The order trace policies of the PriceLevelBookCore. The policy is selected at compile time: with the NoOrderTrace the
+ * trace calls are compiled away. Define DXF_PRICE_LEVEL_BOOK_TRACE (the CMake option of the same name) to trace the
+ * orders of all the books with the RingOrderTrace.
+ */
+
+// The fixed-size binary trace record of an order processed by the book
+struct OrderTraceRecord {
+  dxf_long_t index;
+  double price;
+  double size;
+  dxf_long_t time;
+  dxf_order_side_t side;
+  dxf_event_flags_t eventFlags;
+};
+
+struct NoOrderTrace {
+  static constexpr bool IS_ENABLED = false;
+
+  void trace(const dxf_order_t&) {}
+};
+
+/*
+ * Copies the trace records into the lock-free ring, the background thread drains the ring and formats the records to
+ * the output. The records are dropped (and counted) when the ring is full, the book never waits for the output.
+ *
+ * `trace` must be called by one thread at a time (the book calls it under its mutex).
+ */
+class RingOrderTrace final {
+  struct Impl {
+    SpscRing<OrderTraceRecord> records;
+    std::FILE* out;
+    std::atomic<std::uint64_t> droppedRecords;
+    std::atomic<bool> isStopped;
+    std::thread drainer;
+
+    Impl(std::size_t capacity, std::FILE* output)
+        : records{capacity}, out{output}, droppedRecords{0}, isStopped{false}, drainer{} {}
+
+    bool drain() {
+      OrderTraceRecord record{};
+      auto drained = false;
+
+      while (records.tryPop(record)) {
+        fmt::print(out, "O:ind={},pr={},sz={},sd={}\n", record.index, record.price, record.size,
+                   record.side == dxf_osd_buy ? "buy" : "sell");
+        drained = true;
+      }
+
+      return drained;
+    }
+
+    void run() {
+      while (!isStopped.load(std::memory_order_acquire)) {
+        if (!drain()) {
+          std::fflush(out);
+          std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+      }
+
+      drain();
+      std::fflush(out);
+    }
+  };
+
+  std::unique_ptr<Impl> impl_;
+
+ public:
+  static constexpr bool IS_ENABLED = true;
+
+  explicit RingOrderTrace(std::size_t capacity = 65536, std::FILE* out = stdout)
+      : impl_{std::make_unique<Impl>(capacity, out)} {
+    impl_->drainer = std::thread([impl = impl_.get()] { impl->run(); });
+  }
+
+  RingOrderTrace(RingOrderTrace&&) noexcept = default;
+  RingOrderTrace& operator=(RingOrderTrace&&) = delete;
+
+  ~RingOrderTrace() {
+    if (!impl_) return;
+
+    impl_->isStopped.store(true, std::memory_order_release);
+    impl_->drainer.join();
+  }
+
+  void trace(const dxf_order_t& order) {
+    if (!impl_->records.tryPush(
+          OrderTraceRecord{order.index, order.price, order.size, order.time, order.side, order.event_flags})) {
+      impl_->droppedRecords.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  [[nodiscard]] std::uint64_t getDroppedRecordsNumber() const {
+    return impl_->droppedRecords.load(std::memory_order_relaxed);
+  }
+};
+
+#ifdef DXF_PRICE_LEVEL_BOOK_TRACE
+using DefaultOrderTrace = RingOrderTrace;
+#else
+using DefaultOrderTrace = NoOrderTrace;
+#endif
+
+}  // namespace dxf
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include "PriceLevel.hpp"
+#include "PriceLevelLadder.hpp"
+
+namespace dxf {
+
+/*
+ * The non-owning view of the visible levels of one side of the book (best first). The levels are read from the book's
+ * ladder in place, the fixed point levels are converted on access. The view is valid only while the book is not
+ * changed: in the book handlers or in the PriceLevelBook::withBookView callback.
+ */
+class PriceLevelSideView final {
+ public:
+  // The book specific accessors. The cursor is the ladder specific position of a level.
+  struct Accessors {
+    PriceLevel (*at)(const void* book, PriceLevelSide side, std::size_t index);
+    std::size_t (*bestCursor)(const void* book, PriceLevelSide side);
+    std::size_t (*nextCursor)(const void* book, PriceLevelSide side, std::size_t cursor);
+    PriceLevel (*atCursor)(const void* book, PriceLevelSide side, std::size_t cursor);
+  };
+
+  class Iterator final {
+    const PriceLevelSideView* view_;
+    std::size_t index_;
+    std::size_t cursor_;
+
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = PriceLevel;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = PriceLevel;
+
+    Iterator() : view_{nullptr}, index_{0}, cursor_{0} {}
+
+    Iterator(const PriceLevelSideView* view, std::size_t index, std::size_t cursor)
+        : view_{view}, index_{index}, cursor_{cursor} {}
+
+    PriceLevel operator*() const { return view_->accessors_->atCursor(view_->book_, view_->side_, cursor_); }
+
+    Iterator& operator++() {
+      if (++index_ < view_->size_) {
+        cursor_ = view_->accessors_->nextCursor(view_->book_, view_->side_, cursor_);
+      }
+
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      auto result = *this;
+
+      ++*this;
+
+      return result;
+    }
+
+    friend bool operator==(const Iterator& a, const Iterator& b) { return a.index_ == b.index_; }
+  };
+
+ private:
+  const void* book_;
+  const Accessors* accessors_;
+  PriceLevelSide side_;
+  std::size_t size_;
+
+ public:
+  PriceLevelSideView() : book_{nullptr}, accessors_{nullptr}, side_{PriceLevelSide::ASK}, size_{0} {}
+
+  PriceLevelSideView(const void* book, const Accessors* accessors, PriceLevelSide side, std::size_t size)
+      : book_{book}, accessors_{accessors}, side_{side}, size_{size} {}
+
+  [[nodiscard]] PriceLevelSide getSide() const { return side_; }
+
+  [[nodiscard]] std::size_t size() const { return size_; }
+
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+
+  // The i-th best level. Prefer the iterators for the sequential access: the TICK ladder looks up each index
+  // separately.
+  PriceLevel operator[](std::size_t i) const { return accessors_->at(book_, side_, i); }
+
+  [[nodiscard]] PriceLevel front() const { return (*this)[0]; }
+
+  [[nodiscard]] Iterator begin() const {
+    return size_ == 0 ? end() : Iterator{this, 0, accessors_->bestCursor(book_, side_)};
+  }
+
+  [[nodiscard]] Iterator end() const { return Iterator{this, size_, 0}; }
+};
+
+/*
+ * The view of the visible book. The version is increased by every change of the visible levels and by every new
+ * snapshot, so the consumers can skip the processing if the version has not changed since the last time.
+ */
+struct PriceLevelBookView {
+  std::uint64_t version = 0;
+  PriceLevelSideView asks{};
+  PriceLevelSideView bids{};
+};
+
+}  // namespace dxf
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "FlatHashMap.hpp"
+#include "PriceLevel.hpp"
+
+namespace dxf {
+
+/*
+ * Accumulates the price level changes sets between notifications and merges them by price:
+ * an addition followed by a removal cancels out, repeated updates collapse to the last value, a removal followed by an
+ * addition becomes an update.
+ *
+ * The changes of a side are kept in the vector in the order of their first appearance and found by price with the
+ * FlatHashMap; they are sorted only when taken. The capacities are reused, so the merging does not allocate in the
+ * steady state.
+ */
+class PriceLevelChangesConflator final {
+  enum class ChangeType : int { NONE = 0, ADDITION = 1, UPDATE = 2, REMOVAL = 3 };
+
+  struct Change {
+    ChangeType type;
+    PriceLevel priceLevel;
+  };
+
+  struct PendingChanges {
+    std::vector<Change> changes{};
+
+    // price -> the index of the change
+    FlatHashMap<double, std::uint32_t> indices{};
+
+    void clear() {
+      changes.clear();
+      indices.clear();
+    }
+  };
+
+  PendingChanges asks_;
+  PendingChanges bids_;
+  PriceLevelChangesSet changesSet_;
+
+  static void merge(PendingChanges& pending, const std::vector<PriceLevel>& priceLevels, ChangeType type) {
+    for (const auto& priceLevel : priceLevels) {
+      const auto* index = pending.indices.find(priceLevel.price);
+
+      if (index == nullptr) {
+        pending.indices[priceLevel.price] = static_cast<std::uint32_t>(pending.changes.size());
+        pending.changes.push_back({type, priceLevel});
+
+        continue;
+      }
+
+      auto& change = pending.changes[*index];
+
+      switch (type) {
+        case ChangeType::REMOVAL:
+          // The canceled out change stays in the vector as NONE (it is skipped when taken)
+          change = {change.type == ChangeType::ADDITION ? ChangeType::NONE : ChangeType::REMOVAL, priceLevel};
+
+          break;
+        case ChangeType::ADDITION:
+          change = {change.type == ChangeType::REMOVAL ? ChangeType::UPDATE : ChangeType::ADDITION, priceLevel};
+
+          break;
+        case ChangeType::UPDATE:
+          change = {change.type == ChangeType::ADDITION ? ChangeType::ADDITION : ChangeType::UPDATE, priceLevel};
+
+          break;
+        case ChangeType::NONE:
+          break;
+      }
+    }
+  }
+
+  static void collect(PendingChanges& pending, bool isBid, std::vector<PriceLevel>& additions,
+                      std::vector<PriceLevel>& updates, std::vector<PriceLevel>& removals) {
+    auto& changes = pending.changes;
+
+    // Best first
+    std::sort(changes.begin(), changes.end(), [isBid](const Change& a, const Change& b) {
+      return isBid ? a.priceLevel.price > b.priceLevel.price : a.priceLevel.price < b.priceLevel.price;
+    });
+
+    for (const auto& change : changes) {
+      switch (change.type) {
+        case ChangeType::ADDITION:
+          additions.push_back(change.priceLevel);
+          break;
+        case ChangeType::UPDATE:
+          updates.push_back(change.priceLevel);
+          break;
+        case ChangeType::REMOVAL:
+          removals.push_back(change.priceLevel);
+          break;
+        case ChangeType::NONE:
+          break;
+      }
+    }
+
+    pending.clear();
+  }
+
+ public:
+  PriceLevelChangesConflator() : asks_{}, bids_{}, changesSet_{} {}
+
+  void merge(const PriceLevelChangesSet& changesSet) {
+    merge(asks_, changesSet.removals.asks, ChangeType::REMOVAL);
+    merge(asks_, changesSet.additions.asks, ChangeType::ADDITION);
+    merge(asks_, changesSet.updates.asks, ChangeType::UPDATE);
+    merge(bids_, changesSet.removals.bids, ChangeType::REMOVAL);
+    merge(bids_, changesSet.additions.bids, ChangeType::ADDITION);
+    merge(bids_, changesSet.updates.bids, ChangeType::UPDATE);
+  }
+
+  // Returns true if there are no pending changes (the canceled out changes are not counted)
+  [[nodiscard]] bool empty() const {
+    auto isNone = [](const Change& change) { return change.type == ChangeType::NONE; };
+
+    return std::all_of(asks_.changes.begin(), asks_.changes.end(), isNone) &&
+           std::all_of(bids_.changes.begin(), bids_.changes.end(), isNone);
+  }
+
+  void clear() {
+    asks_.clear();
+    bids_.clear();
+  }
+
+  // Returns the merged changes (best first) and clears the conflator. The result is valid until the next take.
+  const PriceLevelChangesSet& take() {
+    changesSet_.additions.asks.clear();
+    changesSet_.additions.bids.clear();
+    changesSet_.updates.asks.clear();
+    changesSet_.updates.bids.clear();
+    changesSet_.removals.asks.clear();
+    changesSet_.removals.bids.clear();
+
+    collect(asks_, false, changesSet_.additions.asks, changesSet_.updates.asks, changesSet_.removals.asks);
+    collect(bids_, true, changesSet_.additions.bids, changesSet_.updates.bids, changesSet_.removals.bids);
+
+    return changesSet_;
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,815 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <boost/multi_index/hashed_index.hpp>
+#include <boost/multi_index/identity.hpp>
+#include <boost/multi_index/member.hpp>
+#include <boost/multi_index/ordered_index.hpp>
+#include <boost/multi_index/random_access_index.hpp>
+#include <boost/multi_index_container.hpp>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "PriceLevel.hpp"
+#include "PriceSearch.hpp"
+
+namespace dxf {
+
+namespace bmi = boost::multi_index;
+
+template <typename Level>
+using BasicPriceLevelContainer = bmi::multi_index_container<
+  Level, bmi::indexed_by<bmi::random_access<>,
+                         bmi::ordered_unique<bmi::member<Level, decltype(Level::price), &Level::price>>>>;
+
+using PriceLevelContainer = BasicPriceLevelContainer<PriceLevel>;
+
+// The price levels ordered by price without the random access index (the insertions do not shift the other levels).
+// The hashed index finds the levels by price without the tree walks.
+template <typename Level>
+using BasicPriceLevelSet = bmi::multi_index_container<
+  Level, bmi::indexed_by<bmi::ordered_unique<bmi::member<Level, decltype(Level::price), &Level::price>>,
+                         bmi::hashed_unique<bmi::member<Level, decltype(Level::price), &Level::price>>>>;
+
+enum class PriceLevelSide : int { ASK = 0, BID = 1 };
+
+enum class PriceLevelLadderType : int {
+  // The price levels are stored in the boost multi_index container (random access + ordered index)
+  ORDERED = 0,
+
+  // The price levels are stored in the contiguous array indexed by the tick offset from a moving anchor
+  TICK = 1,
+
+  // The visible price levels (and the promotion buffer) are stored in the short sorted arrays searched with SIMD, the
+  // deeper ones in the ordered set with the hashed index. For the books with the small levels number (also the deep
+  // books).
+  SHALLOW = 2
+};
+
+/*
+ * All the ladders have the same interface and address the levels "best first": [0] is the lowest ask or the highest
+ * bid, [1] is the next one, etc. `Level` is PriceLevel or FixedPointPriceLevel.
+ * The cursors (bestCursor, nextCursor, atCursor) walk the levels best first without the index lookups.
+ */
+
+// The one side of the book based on the PriceLevelContainer. The random access index is kept sorted by price.
+template <typename Level>
+class OrderedPriceLevelLadder final {
+  using Number = decltype(Level::price);
+
+  PriceLevelSide side_;
+  BasicPriceLevelContainer<Level> levels_;
+
+ public:
+  static constexpr PriceLevelLadderType TYPE = PriceLevelLadderType::ORDERED;
+
+  explicit OrderedPriceLevelLadder(PriceLevelSide side) : side_{side}, levels_{} {}
+
+  [[nodiscard]] PriceLevelSide getSide() const { return side_; }
+
+  // Returns true if the price1 is closer to the top of the book than the price2
+  [[nodiscard]] bool isBetter(Number price1, Number price2) const {
+    return side_ == PriceLevelSide::BID ? price1 > price2 : price1 < price2;
+  }
+
+  [[nodiscard]] std::size_t size() const { return levels_.size(); }
+
+  [[nodiscard]] bool empty() const { return levels_.empty(); }
+
+  const Level& operator[](std::size_t i) const {
+    return side_ == PriceLevelSide::BID ? levels_[levels_.size() - 1 - i] : levels_[i];
+  }
+
+  [[nodiscard]] std::size_t bestCursor() const { return 0; }
+
+  [[nodiscard]] std::size_t nextCursor(std::size_t cursor) const { return cursor + 1; }
+
+  [[nodiscard]] const Level& atCursor(std::size_t cursor) const { return (*this)[cursor]; }
+
+  // Returns the pointer to the price level with the same price or nullptr
+  [[nodiscard]] const Level* find(Number price) const {
+    auto found = levels_.template get<1>().find(price);
+
+    return found == levels_.template get<1>().end() ? nullptr : &*found;
+  }
+
+  void insert(const Level& priceLevel) {
+    auto& byPrice = levels_.template get<1>();
+    auto position = levels_.template project<0>(byPrice.lower_bound(priceLevel.price));
+
+    levels_.insert(position, priceLevel);
+  }
+
+  void update(const Level& priceLevel) {
+    auto& byPrice = levels_.template get<1>();
+    auto found = byPrice.find(priceLevel.price);
+
+    if (found == byPrice.end()) {
+      insert(priceLevel);
+    } else {
+      byPrice.replace(found, priceLevel);
+    }
+  }
+
+  void erase(Number price) { levels_.template get<1>().erase(price); }
+
+  void clear() { levels_.clear(); }
+
+  // Copies the best `levelsNumber` levels (0 - all levels) to the `to` reusing its capacity
+  void copyTop(std::size_t levelsNumber, std::vector<Level>& to) const {
+    auto n = static_cast<std::ptrdiff_t>((levelsNumber == 0 || levels_.size() <= levelsNumber) ? levels_.size()
+                                                                                              : levelsNumber);
+
+    if (side_ == PriceLevelSide::BID) {
+      to.assign(levels_.rbegin(), levels_.rbegin() + n);
+    } else {
+      to.assign(levels_.begin(), levels_.begin() + n);
+    }
+  }
+
+  // Returns the copy of the best `levelsNumber` levels (0 - all levels)
+  [[nodiscard]] std::vector<Level> copyTop(std::size_t levelsNumber) const {
+    std::vector<Level> result{};
+
+    copyTop(levelsNumber, result);
+
+    return result;
+  }
+};
+
+/*
+ * The one side of the book based on the contiguous array of slots. The slot of a price level is its price in ticks
+ * minus the anchor. The anchor moves (and the array grows up to MAX_CAPACITY slots) when a price falls outside the
+ * array. Insert, update, remove and the best level lookup are O(1). The N-th level lookup skips the empty slots by the
+ * 64-bit words of the occupancy bitmap.
+ *
+ * The prices should be multiples of the tick size (for the FixedPointPriceLevel the tick size is scaled too). A price
+ * that is not on the tick grid or that is too far from the other levels (the span would exceed MAX_CAPACITY ticks)
+ * moves all the levels to the fallback ordered ladder (see isFallback): the levels are never merged or dropped, only
+ * the lookups become O(log n). The ladder returns to the array when such prices are removed (or the ladder is cleared).
+ * Prices that are not finite are ignored.
+ */
+template <typename Level>
+class TickPriceLevelLadder final {
+  using Number = decltype(Level::price);
+
+  static constexpr std::size_t NPOS = std::numeric_limits<std::size_t>::max();
+
+  // The prices in ticks beyond this are not converted exactly (the double mantissa)
+  static constexpr double MAX_TICKS = 4503599627370496.0;  // 2^52
+
+  // The max distance of the price from the tick grid, in ticks (the rounding errors of the floating point prices)
+  static constexpr double TICK_EPSILON = 1e-6;
+
+  PriceLevelSide side_;
+  Number tickSize_;
+  std::int64_t anchor_;
+  std::vector<Level> slots_;
+  std::vector<std::uint64_t> occupancy_;
+  std::size_t size_;
+  std::size_t lowest_;
+  std::size_t highest_;
+
+  // All the levels are in the fallback_ ladder, the array is empty
+  bool isFallback_;
+  OrderedPriceLevelLadder<Level> fallback_;
+
+  // The number of the fallback levels with the prices off the tick grid
+  std::size_t offGridLevelsNumber_;
+
+  // Converts the price to ticks. Returns false if the price is not on the tick grid (or can not be converted exactly).
+  [[nodiscard]] bool toTicks(Number price, std::int64_t& ticks) const {
+    if (!(tickSize_ > 0)) return false;
+
+    if constexpr (std::is_floating_point_v<Number>) {
+      auto exactTicks = static_cast<double>(price) / static_cast<double>(tickSize_);
+
+      if (!(std::abs(exactTicks) < MAX_TICKS)) return false;
+
+      ticks = std::llround(exactTicks);
+
+      return std::abs(exactTicks - static_cast<double>(ticks)) <= TICK_EPSILON;
+    } else {
+      ticks = price / tickSize_;
+
+      return price % tickSize_ == 0;
+    }
+  }
+
+  [[nodiscard]] static bool isFinite(Number price) {
+    if constexpr (std::is_floating_point_v<Number>) {
+      return std::isfinite(price);
+    } else {
+      return true;
+    }
+  }
+
+  [[nodiscard]] bool isOccupied(std::size_t slot) const { return (occupancy_[slot / 64] >> (slot % 64)) & 1U; }
+
+  // Returns the first occupied slot >= `from` or NPOS
+  [[nodiscard]] std::size_t nextOccupied(std::size_t from) const {
+    if (from >= slots_.size()) return NPOS;
+
+    auto word = from / 64;
+    auto bits = occupancy_[word] & (~std::uint64_t{0} << (from % 64));
+
+    while (bits == 0) {
+      if (++word == occupancy_.size()) return NPOS;
+
+      bits = occupancy_[word];
+    }
+
+    return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+  }
+
+  // Returns the last occupied slot <= `from` or NPOS
+  [[nodiscard]] std::size_t previousOccupied(std::size_t from) const {
+    if (from == NPOS) return NPOS;
+
+    auto word = from / 64;
+    auto bits = occupancy_[word] & (~std::uint64_t{0} >> (63 - from % 64));
+
+    while (bits == 0) {
+      if (word-- == 0) return NPOS;
+
+      bits = occupancy_[word];
+    }
+
+    return word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(bits));
+  }
+
+  [[nodiscard]] std::size_t bestSlot() const { return side_ == PriceLevelSide::BID ? highest_ : lowest_; }
+
+  [[nodiscard]] std::size_t nthSlot(std::size_t n) const {
+    if (n == 0) return bestSlot();
+
+    if (side_ == PriceLevelSide::BID) {
+      auto word = highest_ / 64;
+      auto bits = occupancy_[word] & (~std::uint64_t{0} >> (63 - highest_ % 64));
+
+      while (true) {
+        auto count = static_cast<std::size_t>(std::popcount(bits));
+
+        if (n < count) {
+          for (; n > 0; n--) bits &= ~(std::uint64_t{1} << (63 - std::countl_zero(bits)));
+
+          return word * 64 + 63 - static_cast<std::size_t>(std::countl_zero(bits));
+        }
+
+        n -= count;
+        bits = occupancy_[--word];
+      }
+    }
+
+    auto word = lowest_ / 64;
+    auto bits = occupancy_[word] & (~std::uint64_t{0} << (lowest_ % 64));
+
+    while (true) {
+      auto count = static_cast<std::size_t>(std::popcount(bits));
+
+      if (n < count) {
+        for (; n > 0; n--) bits &= bits - 1;
+
+        return word * 64 + static_cast<std::size_t>(std::countr_zero(bits));
+      }
+
+      n -= count;
+      bits = occupancy_[++word];
+    }
+  }
+
+  void relayout(std::int64_t newAnchor, std::size_t newCapacity) {
+    std::vector<Level> newSlots(newCapacity);
+    std::vector<std::uint64_t> newOccupancy(newCapacity / 64);
+    auto offset = anchor_ - newAnchor;
+
+    for (auto slot = lowest_; slot != NPOS; slot = nextOccupied(slot + 1)) {
+      auto newSlot = static_cast<std::size_t>(static_cast<std::int64_t>(slot) + offset);
+
+      newSlots[newSlot] = slots_[slot];
+      newOccupancy[newSlot / 64] |= std::uint64_t{1} << (newSlot % 64);
+    }
+
+    slots_ = std::move(newSlots);
+    occupancy_ = std::move(newOccupancy);
+    anchor_ = newAnchor;
+    lowest_ = static_cast<std::size_t>(static_cast<std::int64_t>(lowest_) + offset);
+    highest_ = static_cast<std::size_t>(static_cast<std::int64_t>(highest_) + offset);
+  }
+
+  // Moves all the levels to the fallback ladder and empties the array (its capacity is kept)
+  void moveToFallback() {
+    for (auto slot = lowest_; slot != NPOS; slot = nextOccupied(slot + 1)) fallback_.insert(slots_[slot]);
+
+    std::fill(occupancy_.begin(), occupancy_.end(), 0);
+    size_ = 0;
+    lowest_ = highest_ = NPOS;
+    isFallback_ = true;
+  }
+
+  // Moves the levels back to the array if they are all on the tick grid and their span fits the array
+  void tryReturnToArray() {
+    std::int64_t lowTicks = 0;
+    std::int64_t highTicks = 0;
+
+    if (offGridLevelsNumber_ != 0 || !toTicks(fallback_[0].price, lowTicks) ||
+        !toTicks(fallback_[fallback_.size() - 1].price, highTicks)) {
+      return;
+    }
+
+    if ((std::max)(lowTicks, highTicks) - (std::min)(lowTicks, highTicks) >= static_cast<std::int64_t>(MAX_CAPACITY)) {
+      return;
+    }
+
+    isFallback_ = false;
+
+    for (auto cursor = fallback_.bestCursor(); cursor < fallback_.size(); cursor = fallback_.nextCursor(cursor)) {
+      insert(fallback_.atCursor(cursor));
+    }
+
+    fallback_.clear();
+  }
+
+  // Returns the slot for the price in ticks. Moves the anchor or grows the array if needed. Returns NPOS if the span of
+  // the levels would exceed MAX_CAPACITY.
+  std::size_t acquireSlot(std::int64_t ticks) {
+    if (slots_.empty()) {
+      slots_.resize(INITIAL_CAPACITY);
+      occupancy_.resize(INITIAL_CAPACITY / 64);
+    }
+
+    auto capacity = static_cast<std::int64_t>(slots_.size());
+
+    if (size_ == 0) {
+      if (ticks < anchor_ || ticks >= anchor_ + capacity) {
+        anchor_ = ticks - capacity / 2;
+      }
+
+      return static_cast<std::size_t>(ticks - anchor_);
+    }
+
+    if (ticks >= anchor_ && ticks < anchor_ + capacity) {
+      return static_cast<std::size_t>(ticks - anchor_);
+    }
+
+    auto lowTicks = (std::min)(ticks, anchor_ + static_cast<std::int64_t>(lowest_));
+    auto highTicks = (std::max)(ticks, anchor_ + static_cast<std::int64_t>(highest_));
+    auto span = highTicks - lowTicks + 1;
+    auto maxCapacity = static_cast<std::int64_t>(MAX_CAPACITY);
+
+    if (span > maxCapacity) return NPOS;
+
+    auto newCapacity = capacity;
+
+    // Leave the headroom on both sides so that a drifting price does not cause the relayout on every tick.
+    while (span * 2 > newCapacity && newCapacity < maxCapacity) {
+      newCapacity *= 2;
+    }
+
+    relayout(lowTicks - (newCapacity - span) / 2, static_cast<std::size_t>(newCapacity));
+
+    return static_cast<std::size_t>(ticks - anchor_);
+  }
+
+ public:
+  static constexpr PriceLevelLadderType TYPE = PriceLevelLadderType::TICK;
+  static constexpr std::size_t INITIAL_CAPACITY = 1024;
+
+  // The max slots number (a power of two): 6 MB of the PriceLevel slots
+  static constexpr std::size_t MAX_CAPACITY = std::size_t{1} << 18U;
+
+  TickPriceLevelLadder(PriceLevelSide side, Number tickSize)
+      : side_{side},
+        tickSize_{tickSize},
+        anchor_{0},
+        slots_{},
+        occupancy_{},
+        size_{0},
+        lowest_{NPOS},
+        highest_{NPOS},
+        isFallback_{false},
+        fallback_{side},
+        offGridLevelsNumber_{0} {}
+
+  [[nodiscard]] PriceLevelSide getSide() const { return side_; }
+
+  // Returns true if the price1 is closer to the top of the book than the price2
+  [[nodiscard]] bool isBetter(Number price1, Number price2) const {
+    return side_ == PriceLevelSide::BID ? price1 > price2 : price1 < price2;
+  }
+
+  // Returns true if the levels are in the fallback ordered ladder (a price was off the tick grid or too far)
+  [[nodiscard]] bool isFallback() const { return isFallback_; }
+
+  [[nodiscard]] std::size_t size() const { return isFallback_ ? fallback_.size() : size_; }
+
+  [[nodiscard]] bool empty() const { return size() == 0; }
+
+  const Level& operator[](std::size_t i) const { return isFallback_ ? fallback_[i] : slots_[nthSlot(i)]; }
+
+  [[nodiscard]] std::size_t bestCursor() const { return isFallback_ ? fallback_.bestCursor() : bestSlot(); }
+
+  [[nodiscard]] std::size_t nextCursor(std::size_t cursor) const {
+    if (isFallback_) return fallback_.nextCursor(cursor);
+
+    return side_ == PriceLevelSide::BID ? previousOccupied(cursor - 1) : nextOccupied(cursor + 1);
+  }
+
+  [[nodiscard]] const Level& atCursor(std::size_t cursor) const {
+    return isFallback_ ? fallback_.atCursor(cursor) : slots_[cursor];
+  }
+
+  // Returns the pointer to the price level with the same price or nullptr
+  [[nodiscard]] const Level* find(Number price) const {
+    if (isFallback_) return fallback_.find(price);
+
+    std::int64_t ticks = 0;
+
+    if (size_ == 0 || !isFinite(price) || !toTicks(price, ticks)) return nullptr;
+
+    auto slot = ticks - anchor_;
+
+    if (slot < 0 || slot >= static_cast<std::int64_t>(slots_.size())) return nullptr;
+
+    return isOccupied(static_cast<std::size_t>(slot)) ? &slots_[static_cast<std::size_t>(slot)] : nullptr;
+  }
+
+  void insert(const Level& priceLevel) {
+    if (!isFinite(priceLevel.price)) return;
+
+    std::int64_t ticks = 0;
+    auto isOnGrid = toTicks(priceLevel.price, ticks);
+
+    if (isFallback_) {
+      if (!isOnGrid && fallback_.find(priceLevel.price) == nullptr) offGridLevelsNumber_++;
+
+      fallback_.update(priceLevel);
+
+      return;
+    }
+
+    auto slot = isOnGrid ? acquireSlot(ticks) : NPOS;
+
+    if (slot == NPOS) {
+      moveToFallback();
+      offGridLevelsNumber_ = isOnGrid ? 0 : 1;
+      fallback_.update(priceLevel);
+
+      return;
+    }
+
+    slots_[slot] = priceLevel;
+
+    if (isOccupied(slot)) return;
+
+    occupancy_[slot / 64] |= std::uint64_t{1} << (slot % 64);
+
+    if (size_++ == 0) {
+      lowest_ = highest_ = slot;
+    } else {
+      lowest_ = (std::min)(lowest_, slot);
+      highest_ = (std::max)(highest_, slot);
+    }
+  }
+
+  void update(const Level& priceLevel) { insert(priceLevel); }
+
+  void erase(Number price) {
+    if (isFallback_) {
+      std::int64_t ticks = 0;
+
+      if (fallback_.find(price) == nullptr) return;
+
+      if (!toTicks(price, ticks)) offGridLevelsNumber_--;
+
+      fallback_.erase(price);
+
+      if (fallback_.empty()) {
+        isFallback_ = false;
+      } else {
+        tryReturnToArray();
+      }
+
+      return;
+    }
+
+    const auto* found = find(price);
+
+    if (found == nullptr) return;
+
+    auto slot = static_cast<std::size_t>(found - slots_.data());
+
+    occupancy_[slot / 64] &= ~(std::uint64_t{1} << (slot % 64));
+
+    if (--size_ == 0) {
+      lowest_ = highest_ = NPOS;
+
+      return;
+    }
+
+    if (slot == lowest_) lowest_ = nextOccupied(slot);
+    if (slot == highest_) highest_ = previousOccupied(slot);
+  }
+
+  void clear() {
+    std::fill(occupancy_.begin(), occupancy_.end(), 0);
+    size_ = 0;
+    lowest_ = highest_ = NPOS;
+    fallback_.clear();
+    isFallback_ = false;
+    offGridLevelsNumber_ = 0;
+  }
+
+  // Copies the best `levelsNumber` levels (0 - all levels) to the `to` reusing its capacity
+  void copyTop(std::size_t levelsNumber, std::vector<Level>& to) const {
+    if (isFallback_) {
+      fallback_.copyTop(levelsNumber, to);
+
+      return;
+    }
+
+    auto n = (levelsNumber == 0 || size_ <= levelsNumber) ? size_ : levelsNumber;
+
+    to.clear();
+    to.reserve(n);
+
+    for (auto slot = bestSlot(); to.size() < n;) {
+      to.push_back(slots_[slot]);
+
+      slot = side_ == PriceLevelSide::BID ? previousOccupied(slot - 1) : nextOccupied(slot + 1);
+    }
+  }
+
+  // Returns the copy of the best `levelsNumber` levels (0 - all levels)
+  [[nodiscard]] std::vector<Level> copyTop(std::size_t levelsNumber) const {
+    std::vector<Level> result{};
+
+    copyTop(levelsNumber, result);
+
+    return result;
+  }
+};
+
+/*
+ * The one side of the book for the small levels numbers. The best levels ("hot") are kept in the short arrays sorted
+ * best first: the prices in the aligned contiguous array, the levels in the parallel one. The positions are found by
+ * the SIMD compares of the prices (see PriceSearch) and the levels are shifted in place. The levels worse than the hot
+ * ones ("cold") are kept in the ordered set with the hashed index: the worst hot level is moved to it when the hot
+ * levels are full. The cold levels are moved back lazily (see promote): only when the hot levels number falls below the
+ * visible levels plus the next one. So on the deep books the updates of the top touch only the hot arrays, and the
+ * updates of the deep levels find them by the hash.
+ *
+ * The hot capacity is the levels number (plus the next level and the promotion buffer) rounded up to the SIMD width, at
+ * most MAX_HOT_CAPACITY. The cold levels are accessed by the index in O(index), so the ladder is for the books with the
+ * levels number that fits the hot capacity.
+ */
+template <typename Level>
+class ShallowPriceLevelLadder final {
+  using Number = decltype(Level::price);
+
+ public:
+  static constexpr PriceLevelLadderType TYPE = PriceLevelLadderType::SHALLOW;
+  static constexpr std::size_t DEFAULT_HOT_CAPACITY = 16;
+  static constexpr std::size_t MAX_HOT_CAPACITY = 64;
+
+  // The hot slots after the visible levels and the next one: the removals of the hot levels are absorbed by them
+  static constexpr std::size_t PROMOTION_BUFFER_SIZE = 8;
+
+ private:
+  static constexpr std::size_t BLOCK_SIZE = 4;
+
+  struct alignas(32) PriceBlock {
+    Number prices[BLOCK_SIZE];
+  };
+
+  static_assert(sizeof(PriceBlock) == BLOCK_SIZE * sizeof(Number), "The price blocks must be contiguous");
+
+  PriceLevelSide side_;
+  std::size_t hotCapacity_;
+
+  // The hot levels number that the book needs: the visible levels and the next one (all the hot slots for 0 levels)
+  std::size_t minHotSize_;
+  std::size_t hotSize_;
+  std::vector<PriceBlock> hotPriceBlocks_;
+  std::vector<Level> hotLevels_;
+  BasicPriceLevelSet<Level> cold_;
+
+  // The price of the unused slots: it is worse than any price
+  [[nodiscard]] Number worstPrice() const {
+    return side_ == PriceLevelSide::BID ? std::numeric_limits<Number>::lowest() : std::numeric_limits<Number>::max();
+  }
+
+  Number* hotPrices() { return hotPriceBlocks_.data()->prices; }
+
+  [[nodiscard]] const Number* hotPrices() const { return hotPriceBlocks_.data()->prices; }
+
+  // The number of the hot slots to search: the used ones rounded up to the block size
+  [[nodiscard]] std::size_t searchSize() const { return (hotSize_ + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE; }
+
+  // The i-th best cold level
+  [[nodiscard]] const Level& coldAt(std::size_t i) const {
+    return side_ == PriceLevelSide::BID ? *std::next(cold_.rbegin(), static_cast<std::ptrdiff_t>(i))
+                                        : *std::next(cold_.begin(), static_cast<std::ptrdiff_t>(i));
+  }
+
+  [[nodiscard]] std::size_t findHot(Number price) const {
+    return PriceSearch::find(hotPrices(), searchSize(), price);
+  }
+
+  void setHot(std::size_t i, const Level& priceLevel) {
+    hotPrices()[i] = priceLevel.price;
+    hotLevels_[i] = priceLevel;
+  }
+
+  void insertHot(std::size_t position, const Level& priceLevel) {
+    auto* prices = hotPrices();
+
+    std::copy_backward(prices + position, prices + hotSize_, prices + hotSize_ + 1);
+    std::copy_backward(hotLevels_.begin() + position, hotLevels_.begin() + hotSize_,
+                       hotLevels_.begin() + hotSize_ + 1);
+    setHot(position, priceLevel);
+    hotSize_++;
+  }
+
+  void eraseHot(std::size_t position) {
+    auto* prices = hotPrices();
+
+    std::copy(prices + position + 1, prices + hotSize_, prices + position);
+    std::copy(hotLevels_.begin() + position + 1, hotLevels_.begin() + hotSize_, hotLevels_.begin() + position);
+    hotSize_--;
+    prices[hotSize_] = worstPrice();
+  }
+
+  // Moves the best cold levels to the hot ones when the hot levels number falls below minHotSize_. The hot levels are
+  // refilled to the middle of the promotion buffer, so the next removals and insertions do not touch the cold levels.
+  void promote() {
+    if (hotSize_ >= minHotSize_ || cold_.empty()) return;
+
+    auto targetSize = minHotSize_ + (hotCapacity_ - minHotSize_ + 1) / 2;
+
+    while (hotSize_ < targetSize && !cold_.empty()) {
+      auto best = side_ == PriceLevelSide::BID ? std::prev(cold_.end()) : cold_.begin();
+
+      setHot(hotSize_++, *best);
+      cold_.erase(best);
+    }
+  }
+
+  static std::size_t toHotCapacity(std::size_t levelsNumber) {
+    if (levelsNumber == 0) return DEFAULT_HOT_CAPACITY;
+
+    return (std::min)((levelsNumber + PROMOTION_BUFFER_SIZE + BLOCK_SIZE) / BLOCK_SIZE * BLOCK_SIZE, MAX_HOT_CAPACITY);
+  }
+
+ public:
+  // `levelsNumber` - the levels number of the book (0 - all levels)
+  ShallowPriceLevelLadder(PriceLevelSide side, std::size_t levelsNumber)
+      : side_{side},
+        hotCapacity_{toHotCapacity(levelsNumber)},
+        minHotSize_{levelsNumber == 0 ? hotCapacity_ : (std::min)(levelsNumber + 1, hotCapacity_)},
+        hotSize_{0},
+        hotPriceBlocks_(hotCapacity_ / BLOCK_SIZE),
+        hotLevels_(hotCapacity_),
+        cold_{} {
+    std::fill(hotPrices(), hotPrices() + hotCapacity_, worstPrice());
+  }
+
+  [[nodiscard]] PriceLevelSide getSide() const { return side_; }
+
+  // Returns true if the price1 is closer to the top of the book than the price2
+  [[nodiscard]] bool isBetter(Number price1, Number price2) const {
+    return side_ == PriceLevelSide::BID ? price1 > price2 : price1 < price2;
+  }
+
+  [[nodiscard]] std::size_t size() const { return hotSize_ + cold_.size(); }
+
+  [[nodiscard]] bool empty() const { return hotSize_ == 0; }
+
+  const Level& operator[](std::size_t i) const { return i < hotSize_ ? hotLevels_[i] : coldAt(i - hotSize_); }
+
+  [[nodiscard]] std::size_t bestCursor() const { return 0; }
+
+  [[nodiscard]] std::size_t nextCursor(std::size_t cursor) const { return cursor + 1; }
+
+  [[nodiscard]] const Level& atCursor(std::size_t cursor) const { return (*this)[cursor]; }
+
+  // Returns the pointer to the price level with the price or nullptr
+  [[nodiscard]] const Level* find(Number price) const {
+    auto i = findHot(price);
+
+    if (i < hotSize_) return &hotLevels_[i];
+
+    // The cold levels are worse than the hot ones
+    if (cold_.empty() || isBetter(price, coldAt(0).price)) return nullptr;
+
+    const auto& coldByPrice = cold_.template get<1>();
+    auto found = coldByPrice.find(price);
+
+    return found == coldByPrice.end() ? nullptr : &*found;
+  }
+
+  void insert(const Level& priceLevel) {
+    auto position = PriceSearch::countBetter(hotPrices(), searchSize(), priceLevel.price, side_ == PriceLevelSide::BID);
+
+    if (position < hotSize_ && hotLevels_[position].price == priceLevel.price) {
+      hotLevels_[position] = priceLevel;
+
+      return;
+    }
+
+    // The levels that are worse than the hot ones go to the cold levels if there are any: the hot levels are refilled
+    // only by promote()
+    if (position == hotCapacity_ || (position == hotSize_ && !cold_.empty())) {
+      if (auto [found, isInserted] = cold_.insert(priceLevel); !isInserted) {
+        cold_.replace(found, priceLevel);
+      }
+
+      return;
+    }
+
+    if (hotSize_ == hotCapacity_) {
+      cold_.insert(hotLevels_[hotSize_ - 1]);
+      hotSize_--;
+    }
+
+    insertHot(position, priceLevel);
+  }
+
+  void update(const Level& priceLevel) {
+    auto i = findHot(priceLevel.price);
+
+    if (i < hotSize_) {
+      hotLevels_[i] = priceLevel;
+
+      return;
+    }
+
+    auto& coldByPrice = cold_.template get<1>();
+
+    if (auto found = coldByPrice.find(priceLevel.price); found != coldByPrice.end()) {
+      coldByPrice.replace(found, priceLevel);
+    }
+  }
+
+  void erase(Number price) {
+    auto i = findHot(price);
+
+    if (i >= hotSize_) {
+      cold_.template get<1>().erase(price);
+
+      return;
+    }
+
+    eraseHot(i);
+    promote();
+  }
+
+  void clear() {
+    std::fill(hotPrices(), hotPrices() + hotCapacity_, worstPrice());
+    hotSize_ = 0;
+    cold_.clear();
+  }
+
+  // Copies the best `levelsNumber` levels (0 - all levels) to the `to` reusing its capacity
+  void copyTop(std::size_t levelsNumber, std::vector<Level>& to) const {
+    auto n = (levelsNumber == 0 || size() <= levelsNumber) ? size() : levelsNumber;
+    auto hotN = (std::min)(n, hotSize_);
+
+    to.assign(hotLevels_.begin(), hotLevels_.begin() + static_cast<std::ptrdiff_t>(hotN));
+
+    if (side_ == PriceLevelSide::BID) {
+      std::copy_n(cold_.rbegin(), n - hotN, std::back_inserter(to));
+    } else {
+      std::copy_n(cold_.begin(), n - hotN, std::back_inserter(to));
+    }
+  }
+
+  // Returns the copy of the best `levelsNumber` levels (0 - all levels)
+  [[nodiscard]] std::vector<Level> copyTop(std::size_t levelsNumber) const {
+    std::vector<Level> result{};
+
+    copyTop(levelsNumber, result);
+
+    return result;
+  }
+};
+
+// Creates the ladder of the given type. The tick size and the levels number are used only by the ladders that need
+// them.
+template <typename Ladder, typename Number>
+Ladder makePriceLevelLadder(PriceLevelSide side, Number tickSize, std::size_t levelsNumber) {
+  if constexpr (Ladder::TYPE == PriceLevelLadderType::TICK) {
+    return Ladder{side, tickSize};
+  } else if constexpr (Ladder::TYPE == PriceLevelLadderType::SHALLOW) {
+    return Ladder{side, levelsNumber};
+  } else {
+    return Ladder{side};
+  }
+}
+
+}  // namespace dxf
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "PriceLevel.hpp"
+#include "PriceLevelBookView.hpp"
+
+namespace dxf {
+
+// The copy of the best levels of the book
+struct PriceLevelTop {
+  // The book version (see PriceLevelBookView)
+  std::uint64_t version = 0;
+  std::vector<PriceLevel> asks{};
+  std::vector<PriceLevel> bids{};
+};
+
+/*
+ * Publishes the best levels of the book to the readers of any threads without the locks. The single writer (the book)
+ * writes the levels into one of the two seqlock protected slots and then publishes the slot. The readers copy the last
+ * published slot and retry only if the writer has started to overwrite it, i.e. if two newer versions were published
+ * during the copy. The readers do not write the shared memory, so they do not slow down each other or the writer.
+ */
+class PriceLevelTopPublisher final {
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  struct AtomicPriceLevel {
+    std::atomic<double> price{0.0};
+    std::atomic<double> size{0.0};
+    std::atomic<std::int64_t> time{0};
+  };
+
+  struct Slot {
+    // Odd while the slot is being written
+    alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> sequence{0};
+    std::atomic<std::uint64_t> version{0};
+    std::atomic<std::size_t> asksNumber{0};
+    std::atomic<std::size_t> bidsNumber{0};
+    std::unique_ptr<AtomicPriceLevel[]> asks{};
+    std::unique_ptr<AtomicPriceLevel[]> bids{};
+  };
+
+  std::size_t depth_;
+  Slot slots_[2];
+
+  // The number of the publications, the last published slot is slots_[(published_ - 1) % 2]
+  alignas(CACHE_LINE_SIZE) std::atomic<std::uint64_t> published_;
+
+  static std::size_t write(const PriceLevelSideView& from, AtomicPriceLevel* to, std::size_t depth) {
+    std::size_t n = 0;
+
+    for (auto it = from.begin(); it != from.end() && n < depth; ++it, ++n) {
+      auto priceLevel = *it;
+
+      to[n].price.store(priceLevel.price, std::memory_order_relaxed);
+      to[n].size.store(priceLevel.size, std::memory_order_relaxed);
+      to[n].time.store(priceLevel.time, std::memory_order_relaxed);
+    }
+
+    return n;
+  }
+
+  static void read(const AtomicPriceLevel* from, std::size_t n, std::vector<PriceLevel>& to) {
+    to.resize(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      to[i] = {from[i].price.load(std::memory_order_relaxed), from[i].size.load(std::memory_order_relaxed),
+               from[i].time.load(std::memory_order_relaxed)};
+    }
+  }
+
+ public:
+  // `depth` - the maximum number of the published levels per side
+  explicit PriceLevelTopPublisher(std::size_t depth) : depth_{depth}, slots_{}, published_{0} {
+    for (auto& slot : slots_) {
+      slot.asks = std::make_unique<AtomicPriceLevel[]>(depth_);
+      slot.bids = std::make_unique<AtomicPriceLevel[]>(depth_);
+    }
+  }
+
+  PriceLevelTopPublisher(const PriceLevelTopPublisher&) = delete;
+  PriceLevelTopPublisher& operator=(const PriceLevelTopPublisher&) = delete;
+
+  [[nodiscard]] std::size_t getDepth() const { return depth_; }
+
+  // The writer side. Must be called by one thread at a time.
+  void publish(const PriceLevelBookView& view) {
+    auto published = published_.load(std::memory_order_relaxed);
+    auto& slot = slots_[published % 2];
+    auto sequence = slot.sequence.load(std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.version.store(view.version, std::memory_order_relaxed);
+    slot.asksNumber.store(write(view.asks, slot.asks.get(), depth_), std::memory_order_relaxed);
+    slot.bidsNumber.store(write(view.bids, slot.bids.get(), depth_), std::memory_order_relaxed);
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+    published_.store(published + 1, std::memory_order_release);
+  }
+
+  // The reader side. Copies the last published levels reusing the capacity of the `to`. Returns the number of the
+  // retries (for the statistics).
+  std::size_t read(PriceLevelTop& to) const {
+    for (std::size_t retries = 0;; retries++) {
+      auto published = published_.load(std::memory_order_acquire);
+
+      if (published == 0) {
+        to.version = 0;
+        to.asks.clear();
+        to.bids.clear();
+
+        return retries;
+      }
+
+      const auto& slot = slots_[(published - 1) % 2];
+      auto sequence = slot.sequence.load(std::memory_order_acquire);
+
+      if ((sequence & 1U) != 0) continue;
+
+      to.version = slot.version.load(std::memory_order_relaxed);
+
+      // The numbers can be inconsistent if the slot is being rewritten, the sequence check below discards the copy
+      auto asksNumber = (std::min)(slot.asksNumber.load(std::memory_order_relaxed), depth_);
+      auto bidsNumber = (std::min)(slot.bidsNumber.load(std::memory_order_relaxed), depth_);
+
+      read(slot.asks.get(), asksNumber, to.asks);
+      read(slot.bids.get(), bidsNumber, to.bids);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (slot.sequence.load(std::memory_order_relaxed) == sequence) return retries;
+    }
+  }
+
+  [[nodiscard]] PriceLevelTop read() const {
+    PriceLevelTop result{};
+
+    read(result);
+
+    return result;
+  }
+};
+
+}  // namespace dxf
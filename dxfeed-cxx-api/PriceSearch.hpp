@@ -0,0 +1,259 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DXF_PRICE_SEARCH_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define DXF_TARGET_AVX2
+#define DXF_TARGET_SSE42
+#else
+#define DXF_TARGET_AVX2 __attribute__((target("avx2")))
+#define DXF_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#endif
+
+namespace dxf {
+
+enum class PriceSearchKernel : int {
+  // The plain loops
+  SCALAR = 0,
+
+  // 2 prices per compare (SSE4.2)
+  SSE42 = 1,
+
+  // 4 prices per compare (AVX2)
+  AVX2 = 2
+};
+
+/*
+ * The search kernels of the short sorted price arrays (double or std::int64_t prices) of the ShallowPriceLevelLadder.
+ * The prices are compared by the vectors with the compare and movemask instructions. The kernel is chosen at runtime by
+ * the CPU features, the SCALAR kernel is used on the other CPUs.
+ *
+ * The arrays are aligned to 32 bytes and their size is a multiple of 4. The unused tail is filled with the prices that
+ * are worse than any real price (see ShallowPriceLevelLadder), so the kernels do not handle the remainders.
+ */
+class PriceSearch final {
+  static PriceSearchKernel detectKernel() {
+#ifdef DXF_PRICE_SEARCH_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4]{};
+
+    __cpuid(info, 1);
+
+    auto hasSse42 = (info[2] & (1 << 20)) != 0;
+    auto hasOsAvx = (info[2] & (1 << 27)) != 0 && (info[2] & (1 << 28)) != 0 && (_xgetbv(0) & 6U) == 6U;
+
+    __cpuidex(info, 7, 0);
+
+    if (hasOsAvx && (info[1] & (1 << 5)) != 0) return PriceSearchKernel::AVX2;
+    if (hasSse42) return PriceSearchKernel::SSE42;
+#else
+    __builtin_cpu_init();
+
+    if (__builtin_cpu_supports("avx2")) return PriceSearchKernel::AVX2;
+    if (__builtin_cpu_supports("sse4.2")) return PriceSearchKernel::SSE42;
+#endif
+#endif
+    return PriceSearchKernel::SCALAR;
+  }
+
+  static PriceSearchKernel& kernel() {
+    static PriceSearchKernel kernel = detectKernel();
+
+    return kernel;
+  }
+
+  template <typename Number>
+  static std::size_t countBetterScalar(const Number* prices, std::size_t n, Number price, bool descending) {
+    std::size_t i = 0;
+
+    if (descending) {
+      while (i < n && prices[i] > price) i++;
+    } else {
+      while (i < n && prices[i] < price) i++;
+    }
+
+    return i;
+  }
+
+  template <typename Number>
+  static std::size_t findScalar(const Number* prices, std::size_t n, Number price) {
+    std::size_t i = 0;
+
+    while (i < n && prices[i] != price) i++;
+
+    return i;
+  }
+
+#ifdef DXF_PRICE_SEARCH_X86
+  // The mask of the lanes where the prices are better than the price
+  template <typename Number>
+  DXF_TARGET_AVX2 static unsigned betterMaskAvx2(const Number* prices, Number price, bool descending) {
+    if constexpr (std::is_same_v<Number, double>) {
+      auto v = _mm256_load_pd(prices);
+      auto p = _mm256_set1_pd(price);
+
+      return static_cast<unsigned>(
+        _mm256_movemask_pd(descending ? _mm256_cmp_pd(v, p, _CMP_GT_OQ) : _mm256_cmp_pd(v, p, _CMP_LT_OQ)));
+    } else {
+      auto v = _mm256_load_si256(reinterpret_cast<const __m256i*>(prices));
+      auto p = _mm256_set1_epi64x(price);
+
+      return static_cast<unsigned>(
+        _mm256_movemask_pd(_mm256_castsi256_pd(descending ? _mm256_cmpgt_epi64(v, p) : _mm256_cmpgt_epi64(p, v))));
+    }
+  }
+
+  template <typename Number>
+  DXF_TARGET_AVX2 static unsigned equalMaskAvx2(const Number* prices, Number price) {
+    if constexpr (std::is_same_v<Number, double>) {
+      return static_cast<unsigned>(
+        _mm256_movemask_pd(_mm256_cmp_pd(_mm256_load_pd(prices), _mm256_set1_pd(price), _CMP_EQ_OQ)));
+    } else {
+      auto v = _mm256_load_si256(reinterpret_cast<const __m256i*>(prices));
+
+      return static_cast<unsigned>(
+        _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, _mm256_set1_epi64x(price)))));
+    }
+  }
+
+  template <typename Number>
+  DXF_TARGET_SSE42 static unsigned betterMaskSse42(const Number* prices, Number price, bool descending) {
+    if constexpr (std::is_same_v<Number, double>) {
+      auto v = _mm_load_pd(prices);
+      auto p = _mm_set1_pd(price);
+
+      return static_cast<unsigned>(_mm_movemask_pd(descending ? _mm_cmpgt_pd(v, p) : _mm_cmplt_pd(v, p)));
+    } else {
+      auto v = _mm_load_si128(reinterpret_cast<const __m128i*>(prices));
+      auto p = _mm_set1_epi64x(price);
+
+      return static_cast<unsigned>(
+        _mm_movemask_pd(_mm_castsi128_pd(descending ? _mm_cmpgt_epi64(v, p) : _mm_cmpgt_epi64(p, v))));
+    }
+  }
+
+  template <typename Number>
+  DXF_TARGET_SSE42 static unsigned equalMaskSse42(const Number* prices, Number price) {
+    if constexpr (std::is_same_v<Number, double>) {
+      return static_cast<unsigned>(_mm_movemask_pd(_mm_cmpeq_pd(_mm_load_pd(prices), _mm_set1_pd(price))));
+    } else {
+      auto v = _mm_load_si128(reinterpret_cast<const __m128i*>(prices));
+
+      return static_cast<unsigned>(_mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, _mm_set1_epi64x(price)))));
+    }
+  }
+
+  // The better prices are the prefix of the sorted array: the first vector that is not all better ends the search
+  template <typename Number>
+  DXF_TARGET_AVX2 static std::size_t countBetterAvx2(const Number* prices, std::size_t n, Number price,
+                                                     bool descending) {
+    for (std::size_t i = 0; i < n; i += 4) {
+      auto mask = betterMaskAvx2(prices + i, price, descending);
+
+      if (mask != 0xFU) return i + static_cast<std::size_t>(std::popcount(mask));
+    }
+
+    return n;
+  }
+
+  template <typename Number>
+  DXF_TARGET_AVX2 static std::size_t findAvx2(const Number* prices, std::size_t n, Number price) {
+    for (std::size_t i = 0; i < n; i += 4) {
+      auto mask = equalMaskAvx2(prices + i, price);
+
+      if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+    }
+
+    return n;
+  }
+
+  template <typename Number>
+  DXF_TARGET_SSE42 static std::size_t countBetterSse42(const Number* prices, std::size_t n, Number price,
+                                                       bool descending) {
+    for (std::size_t i = 0; i < n; i += 2) {
+      auto mask = betterMaskSse42(prices + i, price, descending);
+
+      if (mask != 0x3U) return i + static_cast<std::size_t>(std::popcount(mask));
+    }
+
+    return n;
+  }
+
+  template <typename Number>
+  DXF_TARGET_SSE42 static std::size_t findSse42(const Number* prices, std::size_t n, Number price) {
+    for (std::size_t i = 0; i < n; i += 2) {
+      auto mask = equalMaskSse42(prices + i, price);
+
+      if (mask != 0) return i + static_cast<std::size_t>(std::countr_zero(mask));
+    }
+
+    return n;
+  }
+#endif
+
+ public:
+  // The best kernel supported by the CPU
+  static PriceSearchKernel getSupportedKernel() {
+    static PriceSearchKernel supported = detectKernel();
+
+    return supported;
+  }
+
+  [[nodiscard]] static PriceSearchKernel getKernel() { return kernel(); }
+
+  // Selects the kernel (for example, to compare the kernels). The unsupported kernel is replaced by the best supported
+  // one. Must be called before the ladders are used by other threads.
+  static void setKernel(PriceSearchKernel kernel) {
+    PriceSearch::kernel() =
+      static_cast<int>(kernel) <= static_cast<int>(getSupportedKernel()) ? kernel : getSupportedKernel();
+  }
+
+  // Returns the number of the prices that are better than the price: less than (ascending) or greater than
+  // (descending) it. `prices` are sorted best first.
+  template <typename Number>
+  static std::size_t countBetter(const Number* prices, std::size_t n, Number price, bool descending) {
+    static_assert(std::is_same_v<Number, double> || std::is_same_v<Number, std::int64_t>);
+
+#ifdef DXF_PRICE_SEARCH_X86
+    switch (kernel()) {
+      case PriceSearchKernel::AVX2:
+        return countBetterAvx2(prices, n, price, descending);
+      case PriceSearchKernel::SSE42:
+        return countBetterSse42(prices, n, price, descending);
+      default:
+        break;
+    }
+#endif
+
+    return countBetterScalar(prices, n, price, descending);
+  }
+
+  // Returns the index of the price or n if there is no such price
+  template <typename Number>
+  static std::size_t find(const Number* prices, std::size_t n, Number price) {
+    static_assert(std::is_same_v<Number, double> || std::is_same_v<Number, std::int64_t>);
+
+#ifdef DXF_PRICE_SEARCH_X86
+    switch (kernel()) {
+      case PriceSearchKernel::AVX2:
+        return findAvx2(prices, n, price);
+      case PriceSearchKernel::SSE42:
+        return findSse42(prices, n, price);
+      default:
+        break;
+    }
+#endif
+
+    return findScalar(prices, n, price);
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "StringConverter.hpp"
+
+namespace dxf {
+
+// The quote of one exchange. The side is absent if its price is not finite or its size is not positive.
+struct RegionalQuote {
+  char exchangeCode = '\0';
+  double bidPrice = std::numeric_limits<double>::quiet_NaN();
+  double bidSize = std::numeric_limits<double>::quiet_NaN();
+  std::int64_t bidTime = 0;
+  double askPrice = std::numeric_limits<double>::quiet_NaN();
+  double askSize = std::numeric_limits<double>::quiet_NaN();
+  std::int64_t askTime = 0;
+
+  [[nodiscard]] bool hasBid() const { return std::isfinite(bidPrice) && bidSize > 0.0; }
+
+  [[nodiscard]] bool hasAsk() const { return std::isfinite(askPrice) && askSize > 0.0; }
+};
+
+// The national best bid and offer: the best regional bid and ask. The exchange code of the absent side is '\0'.
+struct NationalBestBidOffer {
+  char bidExchangeCode = '\0';
+  double bidPrice = std::numeric_limits<double>::quiet_NaN();
+  double bidSize = std::numeric_limits<double>::quiet_NaN();
+  std::int64_t bidTime = 0;
+  char askExchangeCode = '\0';
+  double askPrice = std::numeric_limits<double>::quiet_NaN();
+  double askSize = std::numeric_limits<double>::quiet_NaN();
+  std::int64_t askTime = 0;
+};
+
+// The changes of the regional book made by one batch of the regional quotes
+struct RegionalBookChangesSet {
+  // The new quotes of the changed exchanges (in the order of the exchange codes)
+  std::vector<RegionalQuote> quotes{};
+
+  // The NBBO after the changes
+  NationalBestBidOffer nbbo{};
+  bool isBestBidChanged = false;
+  bool isBestAskChanged = false;
+};
+
+/*
+ * The regional book of the symbol: the quotes of the exchanges (see dxf_create_regional_book) and the NBBO computed
+ * from them. The quotes are kept in the fixed array indexed by the exchange code. The NBBO is updated incrementally:
+ * the quote of an exchange that is better than the best one replaces it, and all the exchanges are rescanned only when
+ * the quote of the best exchange gets worse (or is removed).
+ *
+ * The best side is ordered by the price, then by the larger size, then by the exchange code, so the NBBO is the same
+ * as the full scan of the quotes would give. Only the changes are notified (see RegionalBookChangesSet).
+ */
+class RegionalBook final {
+ public:
+  // The exchange codes 'A'..'Z'. The quotes of the other codes are ignored.
+  static constexpr std::size_t EXCHANGES_NUMBER = 26;
+
+ private:
+  // The index of the absent best side
+  static constexpr std::size_t NPOS = EXCHANGES_NUMBER;
+
+  dxf_regional_book_t regionalBook_;
+  std::string symbol_;
+  bool isValid_;
+  std::mutex mutex_;
+
+  std::array<RegionalQuote, EXCHANGES_NUMBER> quotes_;
+  std::size_t bestBid_;
+  std::size_t bestAsk_;
+  std::uint64_t rescansNumber_;
+
+  std::function<void(const RegionalBookChangesSet&)> onIncrementalChange_;
+  std::function<void(const NationalBestBidOffer&)> onNbboChange_;
+
+  // The handlers' argument. Its capacity is reused between the notifications.
+  RegionalBookChangesSet changesSet_;
+
+  static std::size_t toExchangeIndex(dxf_char_t exchangeCode) {
+    return exchangeCode >= L'A' && exchangeCode <= L'Z' ? static_cast<std::size_t>(exchangeCode - L'A') : NPOS;
+  }
+
+  // NaN is the same as NaN: it is the absent price or size
+  static bool isSame(double x, double y) { return x == y || (std::isnan(x) && std::isnan(y)); }
+
+  static bool isSameQuote(const RegionalQuote& a, const RegionalQuote& b) {
+    return isSame(a.bidPrice, b.bidPrice) && isSame(a.bidSize, b.bidSize) && a.bidTime == b.bidTime &&
+           isSame(a.askPrice, b.askPrice) && isSame(a.askSize, b.askSize) && a.askTime == b.askTime;
+  }
+
+  // Returns true if the bid `a` of the exchange `i` is better than the bid `b` of the exchange `j`. Both are present.
+  static bool isBetterBid(const RegionalQuote& a, std::size_t i, const RegionalQuote& b, std::size_t j) {
+    if (a.bidPrice != b.bidPrice) return a.bidPrice > b.bidPrice;
+    if (a.bidSize != b.bidSize) return a.bidSize > b.bidSize;
+
+    return i < j;
+  }
+
+  static bool isBetterAsk(const RegionalQuote& a, std::size_t i, const RegionalQuote& b, std::size_t j) {
+    if (a.askPrice != b.askPrice) return a.askPrice < b.askPrice;
+    if (a.askSize != b.askSize) return a.askSize > b.askSize;
+
+    return i < j;
+  }
+
+  template <typename HasSide, typename IsBetter>
+  std::size_t rescan(HasSide&& hasSide, IsBetter&& isBetter) {
+    std::size_t best = NPOS;
+
+    rescansNumber_++;
+
+    for (std::size_t i = 0; i < EXCHANGES_NUMBER; i++) {
+      if (hasSide(quotes_[i]) && (best == NPOS || isBetter(quotes_[i], i, quotes_[best], best))) best = i;
+    }
+
+    return best;
+  }
+
+  /*
+   * Updates the best side after the quote of the exchange `i` was changed from the `old` one: the better quote takes
+   * the best side, the quote of the best exchange keeps it unless it gets worse. Returns the new best exchange index.
+   */
+  template <typename HasSide, typename IsBetter>
+  std::size_t updateBest(std::size_t best, std::size_t i, const RegionalQuote& old, HasSide&& hasSide,
+                         IsBetter&& isBetter) {
+    const auto& quote = quotes_[i];
+
+    if (best == i) {
+      if (!hasSide(quote) || isBetter(old, i, quote, i)) return rescan(hasSide, isBetter);
+
+      return best;
+    }
+
+    if (hasSide(quote) && (best == NPOS || isBetter(quote, i, quotes_[best], best))) return i;
+
+    return best;
+  }
+
+  [[nodiscard]] NationalBestBidOffer toNbbo() const {
+    NationalBestBidOffer nbbo{};
+
+    if (bestBid_ != NPOS) {
+      const auto& quote = quotes_[bestBid_];
+
+      nbbo.bidExchangeCode = quote.exchangeCode;
+      nbbo.bidPrice = quote.bidPrice;
+      nbbo.bidSize = quote.bidSize;
+      nbbo.bidTime = quote.bidTime;
+    }
+
+    if (bestAsk_ != NPOS) {
+      const auto& quote = quotes_[bestAsk_];
+
+      nbbo.askExchangeCode = quote.exchangeCode;
+      nbbo.askPrice = quote.askPrice;
+      nbbo.askSize = quote.askSize;
+      nbbo.askTime = quote.askTime;
+    }
+
+    return nbbo;
+  }
+
+  explicit RegionalBook(std::string symbol)
+      : regionalBook_{nullptr},
+        symbol_{std::move(symbol)},
+        isValid_{false},
+        mutex_{},
+        quotes_{},
+        bestBid_{NPOS},
+        bestAsk_{NPOS},
+        rescansNumber_{0},
+        onIncrementalChange_{},
+        onNbboChange_{},
+        changesSet_{} {
+    for (std::size_t i = 0; i < EXCHANGES_NUMBER; i++) quotes_[i].exchangeCode = static_cast<char>('A' + i);
+  }
+
+  // Creates the regional book and attaches the listener. Returns false if the book was not created.
+  bool subscribe(dxf_connection_t connection) {
+    auto wSymbol = StringConverter::utf8ToWString(symbol_);
+    dxf_regional_book_t regionalBook = nullptr;
+
+    if (dxf_create_regional_book(connection, wSymbol.c_str(), &regionalBook) == DXF_FAILURE) {
+      return false;
+    }
+
+    regionalBook_ = regionalBook;
+    isValid_ = true;
+
+    dxf_attach_regional_book_listener_v2(
+      regionalBook,
+      [](dxf_const_string_t /*symbol*/, const dxf_quote_t* quotes, int count, void* user_data) {
+        static_cast<RegionalBook*>(user_data)->processQuotes(quotes, count);
+      },
+      this);
+
+    return true;
+  }
+
+  void unsubscribe() {
+    if (isValid_) {
+      dxf_close_regional_book(regionalBook_);
+      isValid_ = false;
+    }
+  }
+
+ public:
+  // Applies the regional quotes and notifies the changes. The quotes without the changes are skipped.
+  void processQuotes(const dxf_quote_t* quotes, int count) {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    auto before = toNbbo();
+    std::uint32_t changedExchanges = 0;
+
+    for (int q = 0; q < count; q++) {
+      const auto& quote = quotes[q];
+      auto i = toExchangeIndex(quote.bid_exchange_code != 0 ? quote.bid_exchange_code : quote.ask_exchange_code);
+
+      if (i == NPOS) continue;
+
+      auto old = quotes_[i];
+      auto& regionalQuote = quotes_[i];
+
+      regionalQuote.bidPrice = quote.bid_price;
+      regionalQuote.bidSize = quote.bid_size;
+      regionalQuote.bidTime = quote.bid_time;
+      regionalQuote.askPrice = quote.ask_price;
+      regionalQuote.askSize = quote.ask_size;
+      regionalQuote.askTime = quote.ask_time;
+
+      if (isSameQuote(old, regionalQuote)) continue;
+
+      changedExchanges |= 1U << i;
+      bestBid_ = updateBest(
+        bestBid_, i, old, [](const RegionalQuote& rq) { return rq.hasBid(); }, &RegionalBook::isBetterBid);
+      bestAsk_ = updateBest(
+        bestAsk_, i, old, [](const RegionalQuote& rq) { return rq.hasAsk(); }, &RegionalBook::isBetterAsk);
+    }
+
+    if (changedExchanges == 0) return;
+
+    changesSet_.quotes.clear();
+
+    for (std::size_t i = 0; i < EXCHANGES_NUMBER; i++) {
+      if ((changedExchanges & (1U << i)) != 0) changesSet_.quotes.push_back(quotes_[i]);
+    }
+
+    auto& nbbo = changesSet_.nbbo;
+
+    nbbo = toNbbo();
+    changesSet_.isBestBidChanged = nbbo.bidExchangeCode != before.bidExchangeCode ||
+                                   !isSame(nbbo.bidPrice, before.bidPrice) || !isSame(nbbo.bidSize, before.bidSize) ||
+                                   nbbo.bidTime != before.bidTime;
+    changesSet_.isBestAskChanged = nbbo.askExchangeCode != before.askExchangeCode ||
+                                   !isSame(nbbo.askPrice, before.askPrice) || !isSame(nbbo.askSize, before.askSize) ||
+                                   nbbo.askTime != before.askTime;
+
+    if (onIncrementalChange_) {
+      onIncrementalChange_(changesSet_);
+    }
+
+    if (onNbboChange_ && (changesSet_.isBestBidChanged || changesSet_.isBestAskChanged)) {
+      onNbboChange_(nbbo);
+    }
+  }
+
+  ~RegionalBook() { unsubscribe(); }
+
+  static std::unique_ptr<RegionalBook> create(dxf_connection_t connection, const std::string& symbol) {
+    auto regionalBook = std::unique_ptr<RegionalBook>(new RegionalBook(symbol));
+
+    regionalBook->subscribe(connection);
+
+    return regionalBook;
+  }
+
+  // The handlers are called by the thread that processes the quotes, under the book lock
+  void setOnIncrementalChange(std::function<void(const RegionalBookChangesSet&)> onIncrementalChangeHandler) {
+    onIncrementalChange_ = std::move(onIncrementalChangeHandler);
+  }
+
+  void setOnNbboChange(std::function<void(const NationalBestBidOffer&)> onNbboChangeHandler) {
+    onNbboChange_ = std::move(onNbboChangeHandler);
+  }
+
+  [[nodiscard]] const std::string& getSymbol() const { return symbol_; }
+
+  [[nodiscard]] NationalBestBidOffer getNbbo() {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return toNbbo();
+  }
+
+  // Returns the quote of the exchange or std::nullopt if the exchange code is not 'A'..'Z'
+  [[nodiscard]] std::optional<RegionalQuote> getQuote(char exchangeCode) {
+    auto i = toExchangeIndex(static_cast<dxf_char_t>(exchangeCode));
+
+    if (i == NPOS) return std::nullopt;
+
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return quotes_[i];
+  }
+
+  // Returns the quotes of the exchanges that have the bid or the ask
+  [[nodiscard]] std::vector<RegionalQuote> getQuotes() {
+    std::vector<RegionalQuote> result{};
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    for (const auto& quote : quotes_) {
+      if (quote.hasBid() || quote.hasAsk()) result.push_back(quote);
+    }
+
+    return result;
+  }
+
+  // Returns the number of the full scans of the exchanges (the best exchange quote got worse or was removed)
+  [[nodiscard]] std::uint64_t getRescansNumber() {
+    std::lock_guard<std::mutex> lk(mutex_);
+
+    return rescansNumber_;
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,494 @@
+#pragma once
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PriceLevel.hpp"
+#include "PriceLevelBookView.hpp"
+#include "PriceLevelTopPublisher.hpp"
+
+namespace dxf {
+
+/*
+ * The layout of the shared memory segment with the best levels of many books (the native byte order):
+ *
+ * [SharedPriceLevelBooksHeader]
+ * [slot 0: SharedPriceLevelBookSlot, SharedPriceLevel asks[depth], SharedPriceLevel bids[depth]] ... [slot N - 1]
+ * [SharedPriceLevelBookChange x ringCapacity]
+ *
+ * Each slot is written by one thread (its book) under the seqlock: the sequence is odd while the slot is being written.
+ * Every slot publication adds an entry to the change ring. The readers follow the ring with their own positions and
+ * detect the overwritten (lost) entries by the entry sequence.
+ */
+struct SharedPriceLevelBooksHeader {
+  char magic[8];
+  std::uint32_t formatVersion;
+  std::uint32_t depth;
+  std::uint32_t slotsCapacity;
+  std::uint32_t ringCapacity;
+  std::uint64_t slotSize;
+
+  // The number of the initialized slots
+  std::atomic<std::uint32_t> booksNumber;
+
+  // The number of the change ring entries claimed by the writers
+  alignas(64) std::atomic<std::uint64_t> ringPosition;
+};
+
+struct SharedPriceLevel {
+  std::atomic<double> price;
+  std::atomic<double> size;
+  std::atomic<std::int64_t> time;
+};
+
+struct alignas(64) SharedPriceLevelBookSlot {
+  // Odd while the slot is being written
+  std::atomic<std::uint64_t> sequence;
+  std::atomic<std::uint64_t> version;
+  std::atomic<std::uint32_t> asksNumber;
+  std::atomic<std::uint32_t> bidsNumber;
+  char symbol[48];
+  char source[16];
+};
+
+struct SharedPriceLevelBookChange {
+  // The ring position + 1 of the entry, 0 while the entry is being written
+  std::atomic<std::uint64_t> sequence;
+  std::atomic<std::uint64_t> version;
+  std::atomic<std::uint32_t> slot;
+  std::uint32_t reserved;
+};
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+              "The shared memory atomics must be lock-free (address-free)");
+
+// The segment mapping and the offsets shared by the writer and the readers
+class SharedPriceLevelBooksSegment {
+ protected:
+  static constexpr char MAGIC[8] = {'D', 'X', 'F', 'P', 'L', 'B', 'S', 'M'};
+  static constexpr std::uint32_t FORMAT_VERSION = 1;
+
+  std::string name_;
+  std::byte* memory_;
+  std::size_t size_;
+
+  static std::size_t slotSize(std::size_t depth) {
+    auto size = sizeof(SharedPriceLevelBookSlot) + 2 * depth * sizeof(SharedPriceLevel);
+
+    return (size + alignof(SharedPriceLevelBookSlot) - 1) / alignof(SharedPriceLevelBookSlot) *
+           alignof(SharedPriceLevelBookSlot);
+  }
+
+  static std::size_t segmentSize(std::size_t slotsCapacity, std::size_t depth, std::size_t ringCapacity) {
+    return sizeof(SharedPriceLevelBooksHeader) + slotsCapacity * slotSize(depth) +
+           ringCapacity * sizeof(SharedPriceLevelBookChange);
+  }
+
+  // Creates the zeroed read-write segment of the size and returns its file id (see getFileId) in the `fileId`. The
+  // existing segment of the name is removed only if `recreate` is true. Returns nullptr on the errors (the name exists)
+  // or if the POSIX shared memory is not supported.
+  static std::byte* createMapping(const std::string& name, std::size_t size, bool recreate, std::uint64_t& fileId) {
+#ifndef _WIN32
+    if (recreate) {
+      shm_unlink(name.c_str());
+    }
+
+    auto fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+
+    if (fd < 0) return nullptr;
+
+    struct stat st {};
+
+    if (ftruncate(fd, static_cast<off_t>(size)) != 0 || fstat(fd, &st) != 0) {
+      close(fd);
+      shm_unlink(name.c_str());
+
+      return nullptr;
+    }
+
+    fileId = static_cast<std::uint64_t>(st.st_ino);
+
+    auto* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (memory != MAP_FAILED) return static_cast<std::byte*>(memory);
+
+    shm_unlink(name.c_str());
+#else
+    (void)name;
+    (void)size;
+    (void)recreate;
+    (void)fileId;
+#endif
+
+    return nullptr;
+  }
+
+  // Maps the existing segment read-only and returns its size in the `size`
+  static std::byte* openMapping(const std::string& name, std::size_t& size) {
+#ifndef _WIN32
+    auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0) return nullptr;
+
+    struct stat st {};
+
+    if (fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(SharedPriceLevelBooksHeader)) {
+      close(fd);
+
+      return nullptr;
+    }
+
+    size = static_cast<std::size_t>(st.st_size);
+
+    auto* memory = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+
+    close(fd);
+
+    if (memory != MAP_FAILED) return static_cast<std::byte*>(memory);
+#else
+    (void)name;
+    (void)size;
+#endif
+
+    return nullptr;
+  }
+
+  // Removes the name if it still refers to the segment with the file id (it can be recreated by another writer)
+  static void removeMapping(const std::string& name, std::uint64_t fileId) {
+#ifndef _WIN32
+    auto fd = shm_open(name.c_str(), O_RDONLY, 0);
+
+    if (fd < 0) return;
+
+    struct stat st {};
+    auto isSame = fstat(fd, &st) == 0 && static_cast<std::uint64_t>(st.st_ino) == fileId;
+
+    close(fd);
+
+    if (isSame) {
+      shm_unlink(name.c_str());
+    }
+#else
+    (void)name;
+    (void)fileId;
+#endif
+  }
+
+  [[nodiscard]] SharedPriceLevelBooksHeader& header() const {
+    return *reinterpret_cast<SharedPriceLevelBooksHeader*>(memory_);
+  }
+
+  [[nodiscard]] SharedPriceLevelBookSlot& slot(std::size_t index) const {
+    return *reinterpret_cast<SharedPriceLevelBookSlot*>(memory_ + sizeof(SharedPriceLevelBooksHeader) +
+                                                         index * header().slotSize);
+  }
+
+  // The asks of the slot followed by the bids
+  [[nodiscard]] SharedPriceLevel* levels(std::size_t index) const {
+    return reinterpret_cast<SharedPriceLevel*>(reinterpret_cast<std::byte*>(&slot(index)) +
+                                               sizeof(SharedPriceLevelBookSlot));
+  }
+
+  [[nodiscard]] SharedPriceLevelBookChange& change(std::uint64_t position) const {
+    auto* ring = reinterpret_cast<SharedPriceLevelBookChange*>(memory_ + sizeof(SharedPriceLevelBooksHeader) +
+                                                               header().slotsCapacity * header().slotSize);
+
+    return ring[position % header().ringCapacity];
+  }
+
+  SharedPriceLevelBooksSegment(std::string name, std::byte* memory, std::size_t size)
+      : name_{std::move(name)}, memory_{memory}, size_{size} {}
+
+  ~SharedPriceLevelBooksSegment() {
+#ifndef _WIN32
+    munmap(memory_, size_);
+#endif
+  }
+
+ public:
+  SharedPriceLevelBooksSegment(const SharedPriceLevelBooksSegment&) = delete;
+  SharedPriceLevelBooksSegment& operator=(const SharedPriceLevelBooksSegment&) = delete;
+
+  [[nodiscard]] const std::string& getName() const { return name_; }
+
+  // The maximum number of the levels per side
+  [[nodiscard]] std::size_t getDepth() const { return header().depth; }
+
+  [[nodiscard]] std::size_t getBooksNumber() const { return header().booksNumber.load(std::memory_order_acquire); }
+
+  [[nodiscard]] std::size_t getBooksCapacity() const { return header().slotsCapacity; }
+};
+
+/*
+ * The publisher side: creates the POSIX shared memory segment and writes the best levels of the books into it (see
+ * PriceLevelBook::publishTo). The slots are added by one thread, each slot is published by one thread at a time (its
+ * book), the different slots can be published concurrently. The segment name is removed when the writer is destroyed
+ * (unless it was taken by another writer), the readers that have mapped it keep their mappings.
+ */
+class SharedPriceLevelBooksWriter final : public SharedPriceLevelBooksSegment {
+  // The inode of the segment: the name is removed only while it refers to this segment
+  std::uint64_t fileId_;
+
+  SharedPriceLevelBooksWriter(std::string name, std::byte* memory, std::size_t size, std::uint64_t fileId)
+      : SharedPriceLevelBooksSegment(std::move(name), memory, size), fileId_{fileId} {}
+
+  static std::uint32_t write(const PriceLevelSideView& from, SharedPriceLevel* to, std::size_t depth) {
+    std::uint32_t n = 0;
+
+    for (auto it = from.begin(); it != from.end() && n < depth; ++it, ++n) {
+      auto priceLevel = *it;
+
+      to[n].price.store(priceLevel.price, std::memory_order_relaxed);
+      to[n].size.store(priceLevel.size, std::memory_order_relaxed);
+      to[n].time.store(priceLevel.time, std::memory_order_relaxed);
+    }
+
+    return n;
+  }
+
+ public:
+  /*
+   * Creates the segment. `name` - the POSIX shared memory name ("/books"), `booksCapacity` - the maximum number of the
+   * books, `depth` - the maximum number of the levels per side, `ringCapacity` - the number of the change ring entries,
+   * `recreate` - replace the existing segment of the name (e.g. left by the crashed writer; its readers are left on the
+   * old segment). Returns nullptr if the segment can not be created, the name exists and `recreate` is false, or the
+   * platform is not POSIX.
+   */
+  static std::unique_ptr<SharedPriceLevelBooksWriter> create(const std::string& name, std::size_t booksCapacity,
+                                                             std::size_t depth, std::size_t ringCapacity = 65536,
+                                                             bool recreate = false) {
+    if (booksCapacity == 0 || depth == 0 || ringCapacity == 0) return nullptr;
+
+    auto size = segmentSize(booksCapacity, depth, ringCapacity);
+    std::uint64_t fileId = 0;
+    auto* memory = createMapping(name, size, recreate, fileId);
+
+    if (memory == nullptr) return nullptr;
+
+    auto writer =
+      std::unique_ptr<SharedPriceLevelBooksWriter>(new SharedPriceLevelBooksWriter(name, memory, size, fileId));
+
+    // The memory is zeroed by ftruncate. The magic is written last: the readers check it.
+    auto* header = new (memory) SharedPriceLevelBooksHeader{};
+
+    header->formatVersion = FORMAT_VERSION;
+    header->depth = static_cast<std::uint32_t>(depth);
+    header->slotsCapacity = static_cast<std::uint32_t>(booksCapacity);
+    header->ringCapacity = static_cast<std::uint32_t>(ringCapacity);
+    header->slotSize = slotSize(depth);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, MAGIC, sizeof(MAGIC));
+
+    return writer;
+  }
+
+  ~SharedPriceLevelBooksWriter() { removeMapping(name_, fileId_); }
+
+  // Adds the slot of the book. Returns the slot index or -1 if the segment is full or the names are too long.
+  int addBook(const std::string& symbol, const std::string& source) {
+    auto index = header().booksNumber.load(std::memory_order_relaxed);
+
+    if (index == header().slotsCapacity || symbol.size() >= sizeof(SharedPriceLevelBookSlot::symbol) ||
+        source.size() >= sizeof(SharedPriceLevelBookSlot::source)) {
+      return -1;
+    }
+
+    auto& s = *new (&slot(index)) SharedPriceLevelBookSlot{};
+
+    std::memcpy(s.symbol, symbol.c_str(), symbol.size());
+    std::memcpy(s.source, source.c_str(), source.size());
+    header().booksNumber.store(index + 1, std::memory_order_release);
+
+    return static_cast<int>(index);
+  }
+
+  // Writes the best levels of the book view to the slot and adds the change to the ring
+  void publish(std::size_t index, const PriceLevelBookView& view) {
+    auto& s = slot(index);
+    auto* asks = levels(index);
+    auto depth = header().depth;
+    auto sequence = s.sequence.load(std::memory_order_relaxed);
+
+    s.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    s.version.store(view.version, std::memory_order_relaxed);
+    s.asksNumber.store(write(view.asks, asks, depth), std::memory_order_relaxed);
+    s.bidsNumber.store(write(view.bids, asks + depth, depth), std::memory_order_relaxed);
+
+    s.sequence.store(sequence + 2, std::memory_order_release);
+
+    // The entries are claimed by the writers of the other slots concurrently
+    auto position = header().ringPosition.fetch_add(1, std::memory_order_acq_rel);
+    auto& c = change(position);
+
+    c.sequence.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    c.slot.store(static_cast<std::uint32_t>(index), std::memory_order_relaxed);
+    c.version.store(view.version, std::memory_order_relaxed);
+    c.sequence.store(position + 1, std::memory_order_release);
+  }
+};
+
+/*
+ * The reader side: maps the segment read-only, so it can be used by any process on the host. The readers do not write
+ * the shared memory and do not slow down each other or the writer (see PriceLevelTopPublisher).
+ */
+class SharedPriceLevelBooksReader final : public SharedPriceLevelBooksSegment {
+  SharedPriceLevelBooksReader(std::string name, std::byte* memory, std::size_t size)
+      : SharedPriceLevelBooksSegment(std::move(name), memory, size) {}
+
+  static void read(const SharedPriceLevel* from, std::size_t n, std::vector<PriceLevel>& to) {
+    to.resize(n);
+
+    for (std::size_t i = 0; i < n; i++) {
+      to[i] = {from[i].price.load(std::memory_order_relaxed), from[i].size.load(std::memory_order_relaxed),
+               from[i].time.load(std::memory_order_relaxed)};
+    }
+  }
+
+ public:
+  // Opens the segment created by the SharedPriceLevelBooksWriter. Returns nullptr if there is no valid segment.
+  static std::unique_ptr<SharedPriceLevelBooksReader> open(const std::string& name) {
+    std::size_t size = 0;
+    auto* memory = openMapping(name, size);
+
+    if (memory == nullptr) return nullptr;
+
+    auto reader = std::unique_ptr<SharedPriceLevelBooksReader>(new SharedPriceLevelBooksReader(name, memory, size));
+    const auto& header = reader->header();
+
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.formatVersion != FORMAT_VERSION ||
+        header.ringCapacity == 0 || header.slotSize != slotSize(header.depth) ||
+        segmentSize(header.slotsCapacity, header.depth, header.ringCapacity) != size) {
+      return nullptr;
+    }
+
+    return reader;
+  }
+
+  // Returns the slot index of the book or -1
+  [[nodiscard]] int findBook(const std::string& symbol, const std::string& source) const {
+    auto booksNumber = getBooksNumber();
+
+    for (std::size_t i = 0; i < booksNumber; i++) {
+      const auto& s = slot(i);
+
+      if (symbol == std::string(s.symbol, strnlen(s.symbol, sizeof(s.symbol))) &&
+          source == std::string(s.source, strnlen(s.source, sizeof(s.source)))) {
+        return static_cast<int>(i);
+      }
+    }
+
+    return -1;
+  }
+
+  // The read attempts that spin before the reader starts to yield between them
+  static constexpr std::size_t SPIN_RETRIES = 64;
+
+  // The default read attempts budget (see read)
+  static constexpr std::size_t MAX_RETRIES = 100000;
+
+  /*
+   * Copies the last published levels of the slot reusing the capacity of the `to`. Retries while the slot is being
+   * written: spins for SPIN_RETRIES attempts, then yields between them. Returns the number of the retries (for the
+   * statistics) or std::nullopt if there was no consistent copy in `maxRetries` attempts, e.g. the writer process died
+   * in the middle of the write. The `to` must not be used then (it is stale or inconsistent).
+   */
+  std::optional<std::size_t> read(std::size_t index, PriceLevelTop& to, std::size_t maxRetries = MAX_RETRIES) const {
+    const auto& s = slot(index);
+    const auto* asks = levels(index);
+    std::size_t depth = header().depth;
+
+    for (std::size_t retries = 0; retries <= maxRetries; retries++) {
+      if (retries > SPIN_RETRIES) {
+        std::this_thread::yield();
+      }
+
+      auto sequence = s.sequence.load(std::memory_order_acquire);
+
+      if ((sequence & 1U) != 0) continue;
+
+      to.version = s.version.load(std::memory_order_relaxed);
+
+      // The numbers can be inconsistent if the slot is being rewritten, the sequence check below discards the copy
+      auto asksNumber = (std::min)(static_cast<std::size_t>(s.asksNumber.load(std::memory_order_relaxed)), depth);
+      auto bidsNumber = (std::min)(static_cast<std::size_t>(s.bidsNumber.load(std::memory_order_relaxed)), depth);
+
+      read(asks, asksNumber, to.asks);
+      read(asks + depth, bidsNumber, to.bids);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      if (s.sequence.load(std::memory_order_relaxed) == sequence) return retries;
+    }
+
+    return std::nullopt;
+  }
+
+  // The ring position of the next change (to follow the changes from now on)
+  [[nodiscard]] std::uint64_t getChangesPosition() const {
+    return header().ringPosition.load(std::memory_order_acquire);
+  }
+
+  /*
+   * Calls the f(std::size_t slot, std::uint64_t version) for the changes published since the `position` and advances
+   * it. Stops at the change that is still being written. Returns the number of the lost changes (overwritten before
+   * they were polled): the reader should reread all its slots then.
+   */
+  template <typename F>
+  std::uint64_t pollChanges(std::uint64_t& position, F&& f) const {
+    auto end = header().ringPosition.load(std::memory_order_acquire);
+    std::uint64_t capacity = header().ringCapacity;
+    std::uint64_t lost = 0;
+
+    if (end - position > capacity) {
+      lost = end - capacity - position;
+      position = end - capacity;
+    }
+
+    for (; position < end; position++) {
+      const auto& c = change(position);
+      auto sequence = c.sequence.load(std::memory_order_acquire);
+
+      // Not written yet
+      if (sequence < position + 1) break;
+
+      auto slot = c.slot.load(std::memory_order_relaxed);
+      auto version = c.version.load(std::memory_order_relaxed);
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+
+      // Overwritten by a newer change
+      if (sequence != position + 1 || c.sequence.load(std::memory_order_relaxed) != sequence) {
+        lost++;
+
+        continue;
+      }
+
+      f(static_cast<std::size_t>(slot), version);
+    }
+
+    return lost;
+  }
+};
+
+}  // namespace dxf
@@ -5,22 +5,39 @@
 #include <future>
 #include <thread>
 #include <mutex>
+#include <type_traits>
 #include "TimeAndSale.hpp"
+#include "TimeAndSaleColumns.hpp"
 
 namespace dxf {
 
 struct SimpleTimeAndSaleDataProvider {
   using ResultType = std::unordered_map<std::string, std::vector<TimeAndSale>>;
   using ResultFutureType = std::future<ResultType>;
+  using ColumnsResultType = std::unordered_map<std::string, TimeAndSaleColumns>;
+  using ColumnsResultFutureType = std::future<ColumnsResultType>;
 
   SimpleTimeAndSaleDataProvider() = default;
 
   static ResultFutureType run(const std::string &address, const std::vector<std::string> &symbols, int timeout = 0) {
+    return runImpl<ResultType>(address, symbols, timeout);
+  }
+
+  // Collects the trades to the columns (see TimeAndSaleColumns) directly from the C API events
+  static ColumnsResultFutureType runColumns(const std::string &address, const std::vector<std::string> &symbols,
+                                            int timeout = 0) {
+    return runImpl<ColumnsResultType>(address, symbols, timeout);
+  }
+
+ private:
+  template <typename Result>
+  static std::future<Result> runImpl(const std::string &address, const std::vector<std::string> &symbols,
+                                     int timeout) {
     return std::async(std::launch::async, [address, symbols, timeout]() {
       struct Impl {
         std::atomic<bool> disconnected_ = false;
         std::mutex eventsMutex_{};
-        ResultType events_{};
+        Result events_{};
         std::mutex cvMutex_{};
         std::condition_variable cv_{};
       } impl;
@@ -51,14 +68,16 @@ struct SimpleTimeAndSaleDataProvider {
           if (eventType == DXF_ET_TIME_AND_SALE) {
             const auto *tns = reinterpret_cast<const dxf_time_and_sale_t *>(eventData);
             auto *implPtr = static_cast<Impl *>(userData);
-            auto symbol = StringConverter::wStringToUtf8(std::wstring(symbolName));
-            auto timeAndSale = TimeAndSale(symbol, *tns);
+            auto symbol = InternedString(symbolName);
 
-            std::lock_guard guard(implPtr->eventsMutex_);
-            if (auto found = implPtr->events_.find(symbol); found != implPtr->events_.end()) {
-              found->second.emplace_back(timeAndSale);
+            if constexpr (std::is_same_v<Result, ColumnsResultType>) {
+              std::lock_guard guard(implPtr->eventsMutex_);
+              implPtr->events_.try_emplace(symbol.get(), symbol).first->second.append(*tns);
             } else {
-              implPtr->events_[symbol] = {timeAndSale};
+              auto timeAndSale = TimeAndSale(symbol, *tns);
+
+              std::lock_guard guard(implPtr->eventsMutex_);
+              implPtr->events_[symbol.get()].emplace_back(timeAndSale);
             }
           }
         },
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace dxf {
+
+/*
+ * The pool of the objects allocated by the slabs. The objects do not move, the released objects are reused, so the
+ * pool allocates only when all the slabs are in use.
+ */
+template <typename T, std::size_t SLAB_SIZE = 4096>
+class SlabPool final {
+  std::vector<std::unique_ptr<T[]>> slabs_;
+  std::vector<T*> free_;
+
+  void addSlab() {
+    slabs_.push_back(std::make_unique<T[]>(SLAB_SIZE));
+    free_.reserve(slabs_.size() * SLAB_SIZE);
+
+    // The objects are acquired in the order of their addresses
+    for (std::size_t i = SLAB_SIZE; i > 0; i--) {
+      free_.push_back(&slabs_.back()[i - 1]);
+    }
+  }
+
+ public:
+  SlabPool() = default;
+  SlabPool(const SlabPool&) = delete;
+  SlabPool& operator=(const SlabPool&) = delete;
+  SlabPool(SlabPool&&) noexcept = default;
+  SlabPool& operator=(SlabPool&&) noexcept = default;
+
+  // Returns the object, its state is the state of the last released object at the same address
+  T* acquire() {
+    if (free_.empty()) addSlab();
+
+    auto* result = free_.back();
+
+    free_.pop_back();
+
+    return result;
+  }
+
+  void release(T* object) { free_.push_back(object); }
+
+  // Releases all the objects
+  void releaseAll() {
+    free_.clear();
+
+    for (auto slab = slabs_.rbegin(); slab != slabs_.rend(); ++slab) {
+      for (std::size_t i = SLAB_SIZE; i > 0; i--) {
+        free_.push_back(&(*slab)[i - 1]);
+      }
+    }
+  }
+
+  // Preallocates the slabs for the `size` objects
+  void reserve(std::size_t size) {
+    while (slabs_.size() * SLAB_SIZE < size) addSlab();
+  }
+
+  [[nodiscard]] std::size_t capacity() const { return slabs_.size() * SLAB_SIZE; }
+};
+
+}  // namespace dxf
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <type_traits>
+#include <vector>
+
+namespace dxf {
+
+/*
+ * The bounded lock-free single producer single consumer queue. The storage is allocated once, the capacity is rounded
+ * up to the power of two. Each side caches the position of the other side to avoid touching its cache line on every
+ * operation.
+ */
+template <typename T>
+class SpscRing final {
+  static_assert(std::is_trivially_copyable_v<T>, "SpscRing supports only trivially copyable types");
+
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  std::vector<T> buffer_;
+  std::size_t mask_;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head_;
+  std::size_t cachedTail_;
+
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail_;
+  std::size_t cachedHead_;
+
+  static std::size_t roundUpToPowerOfTwo(std::size_t value) {
+    std::size_t result = 1;
+
+    while (result < value) result <<= 1U;
+
+    return result;
+  }
+
+ public:
+  explicit SpscRing(std::size_t capacity)
+      : buffer_(roundUpToPowerOfTwo(capacity == 0 ? 1 : capacity)),
+        mask_{buffer_.size() - 1},
+        head_{0},
+        cachedTail_{0},
+        tail_{0},
+        cachedHead_{0} {}
+
+  SpscRing(const SpscRing&) = delete;
+  SpscRing& operator=(const SpscRing&) = delete;
+
+  [[nodiscard]] std::size_t capacity() const { return buffer_.size(); }
+
+  // The approximate number of elements. Can be called from any thread.
+  [[nodiscard]] std::size_t size() const {
+    return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_acquire);
+  }
+
+  // Producer side
+  bool tryPush(const T& value) {
+    auto tail = tail_.load(std::memory_order_relaxed);
+
+    if (tail - cachedHead_ == buffer_.size()) {
+      cachedHead_ = head_.load(std::memory_order_acquire);
+
+      if (tail - cachedHead_ == buffer_.size()) return false;
+    }
+
+    buffer_[tail & mask_] = value;
+    tail_.store(tail + 1, std::memory_order_release);
+
+    return true;
+  }
+
+  // Consumer side
+  bool tryPop(T& value) {
+    auto head = head_.load(std::memory_order_relaxed);
+
+    if (head == cachedTail_) {
+      cachedTail_ = tail_.load(std::memory_order_acquire);
+
+      if (head == cachedTail_) return false;
+    }
+
+    value = buffer_[head & mask_];
+    head_.store(head + 1, std::memory_order_release);
+
+    return true;
+  }
+};
+
+}  // namespace dxf
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
 
 #ifdef _MSC_FULL_VER
@@ -8,6 +9,7 @@
 #endif
 
 #include <codecvt>
+#include <locale>
 
 namespace dxf {
 
@@ -63,8 +65,9 @@ struct StringConverter {
   }
 
   static char wCharToUtf8(wchar_t c) noexcept {
-    if (c == L'\0') {
-      return '\0';
+    // ASCII (the exchange codes, the flags) is the same in UTF-8
+    if (static_cast<std::uint32_t>(c) < 0x80) {
+      return static_cast<char>(c);
     }
 
     return wStringToUtf8(std::wstring(1, c))[0];
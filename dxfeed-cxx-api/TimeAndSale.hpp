@@ -3,8 +3,11 @@
 #include <DXFeed.h>
 
 #include <cstdint>
+#include <limits>
 #include <string>
+#include <type_traits>
 
+#include "InternedString.hpp"
 #include "MarketEvent.hpp"
 #include "OrderScope.hpp"
 #include "OrderSide.hpp"
@@ -15,69 +18,70 @@ namespace dxf {
 
 enum class TimeAndSaleType : int { NEW = 0, CORRECTION = 1, CANCEL = 2 };
 
-class TimeAndSale final : public MarketEvent, public TimeSeriesEvent<std::string> {
-  std::uint32_t eventFlags_{};
+/*
+ * The trade. The event is the plain standard-layout class (no virtual functions, see EventType): the event symbol, the
+ * event time, the flags and the index are accessed by the MarketEvent and TimeSeriesEvent mixins. The strings are
+ * interned (see StringTable), so the event is trivially copyable and its construction does not allocate once the
+ * strings are known.
+ */
+class TimeAndSale final : public MarketEvent<TimeAndSale>, public TimeSeriesEvent<TimeAndSale> {
+  friend class MarketEvent<TimeAndSale>;
+  friend class IndexedEvent<TimeAndSale>;
+
+  // The fields are ordered by the alignment (the 8-byte ones, the 4-byte ones, the bytes): no padding
+  InternedString eventSymbol_{};
+  InternedString exchangeSaleConditions_{};
+  InternedString buyer_{};
+  InternedString seller_{};
+  std::uint64_t eventTime_{};
   std::uint64_t index_{};
   std::uint64_t time_{};
-  char exchangeCode_{};
   double price_{std::numeric_limits<double>::quiet_NaN()};
   double size_{std::numeric_limits<double>::quiet_NaN()};
   double bidPrice_{std::numeric_limits<double>::quiet_NaN()};
   double askPrice_{std::numeric_limits<double>::quiet_NaN()};
-  std::string exchangeSaleConditions_{};
+  std::uint32_t eventFlags_{};
   std::int32_t flags_{};
-  std::string buyer_{};
-  std::string seller_{};
   OrderSide side_{};
   TimeAndSaleType type_{};
+  OrderScope scope_{};
+  char exchangeCode_{};
+  char tradeThroughExempt_ = false;
   bool isValidTick_ = false;
   bool isEthTrade_ = false;
-  char tradeThroughExempt_ = false;
   bool isSpreadLeg_ = false;
-  OrderScope scope_{};
 
  public:
   TimeAndSale() = default;
 
-  explicit TimeAndSale(const std::string &eventSymbol) : MarketEvent(eventSymbol) {}
+  explicit TimeAndSale(const std::string &eventSymbol) : eventSymbol_{eventSymbol} {}
+
+  explicit TimeAndSale(InternedString eventSymbol) : eventSymbol_{eventSymbol} {}
 
   explicit TimeAndSale(const std::string &eventSymbol, const dxf_time_and_sale_t &tns)
-      : MarketEvent(eventSymbol),
-        eventFlags_{tns.event_flags},
+      : TimeAndSale{InternedString{eventSymbol}, tns} {}
+
+  explicit TimeAndSale(InternedString eventSymbol, const dxf_time_and_sale_t &tns)
+      : eventSymbol_{eventSymbol},
+        exchangeSaleConditions_{tns.exchange_sale_conditions},
+        buyer_{tns.buyer},
+        seller_{tns.seller},
         index_{static_cast<uint64_t>(tns.index)},
         time_{static_cast<uint64_t>(tns.time)},
-        exchangeCode_{StringConverter::wCharToUtf8(tns.exchange_code)},
         price_{tns.price},
         size_{tns.size},
         bidPrice_{tns.bid_price},
         askPrice_{tns.ask_price},
-        exchangeSaleConditions_(StringConverter::wStringToUtf8(tns.exchange_sale_conditions)),
+        eventFlags_{tns.event_flags},
         flags_{tns.raw_flags},
-        buyer_(StringConverter::wStringToUtf8(tns.buyer)),
-        seller_(StringConverter::wStringToUtf8(tns.seller)),
         side_{static_cast<OrderSide>(tns.side)},
         type_{static_cast<TimeAndSaleType>(tns.type)},
+        scope_{static_cast<OrderScope>(tns.scope)},
+        exchangeCode_{StringConverter::wCharToUtf8(tns.exchange_code)},
+        tradeThroughExempt_{StringConverter::wCharToUtf8(tns.trade_through_exempt)},
         isValidTick_{static_cast<bool>(tns.is_valid_tick)},
         isEthTrade_{static_cast<bool>(tns.is_eth_trade)},
-        tradeThroughExempt_{StringConverter::wCharToUtf8(tns.trade_through_exempt)},
-        isSpreadLeg_{static_cast<bool>(tns.is_spread_leg)},
-        scope_{static_cast<OrderScope>(tns.scope)} {}
-
-  [[nodiscard]] const std::string &getEventSymbol() const override { return MarketEvent::getEventSymbol(); }
-
-  void setEventSymbol(const std::string &eventSymbol) override { MarketEvent::setEventSymbol(eventSymbol); }
-
-  uint64_t getEventTime() override { return MarketEvent::getEventTime(); }
-
-  void setEventTime(std::uint64_t eventTime) override { MarketEvent::setEventTime(eventTime); }
-
-  std::uint32_t getEventFlags() override { return eventFlags_; }
-
-  void setEventFlags(std::uint32_t eventFlags) override { eventFlags_ = eventFlags; }
-
-  std::uint64_t getIndex() override { return index_; }
-
-  void setIndex(std::uint64_t index) override { index_ = index; }
+        isSpreadLeg_{static_cast<bool>(tns.is_spread_leg)} {}
 
   [[nodiscard]] std::uint64_t getTime() const { return time_; }
 
@@ -103,23 +107,23 @@ class TimeAndSale final : public MarketEvent, public TimeSeriesEvent<std::string
 
   void setAskPrice(double askPrice) { askPrice_ = askPrice; }
 
-  [[nodiscard]] const std::string &getExchangeSaleConditions() const { return exchangeSaleConditions_; }
+  [[nodiscard]] const std::string &getExchangeSaleConditions() const { return exchangeSaleConditions_.get(); }
 
   void setExchangeSaleConditions(const std::string &exchangeSaleConditions) {
-    exchangeSaleConditions_ = exchangeSaleConditions;
+    exchangeSaleConditions_ = InternedString{exchangeSaleConditions};
   }
 
   [[nodiscard]] int32_t getFlags() const { return flags_; }
 
   void setFlags(int32_t flags) { flags_ = flags; }
 
-  [[nodiscard]] const std::string &getBuyer() const { return buyer_; }
+  [[nodiscard]] const std::string &getBuyer() const { return buyer_.get(); }
 
-  void setBuyer(const std::string &buyer) { buyer_ = buyer; }
+  void setBuyer(const std::string &buyer) { buyer_ = InternedString{buyer}; }
 
-  [[nodiscard]] const std::string &getSeller() const { return seller_; }
+  [[nodiscard]] const std::string &getSeller() const { return seller_.get(); }
 
-  void setSeller(const std::string &seller) { seller_ = seller; }
+  void setSeller(const std::string &seller) { seller_ = InternedString{seller}; }
 
   [[nodiscard]] OrderSide getSide() const { return side_; }
 
@@ -148,8 +152,10 @@ class TimeAndSale final : public MarketEvent, public TimeSeriesEvent<std::string
   [[nodiscard]] OrderScope getScope() const { return scope_; }
 
   void setScope(OrderScope scope) { scope_ = scope; }
-
-  ~TimeAndSale() override = default;
 };
 
+static_assert(TimeSeriesEventType<TimeAndSale>);
+static_assert(!std::is_polymorphic_v<TimeAndSale> && std::is_standard_layout_v<TimeAndSale>);
+static_assert(std::is_trivially_copyable_v<TimeAndSale>);
+
 }
\ No newline at end of file
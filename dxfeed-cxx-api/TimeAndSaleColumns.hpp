@@ -0,0 +1,336 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "FlatHashMap.hpp"
+#include "InternedString.hpp"
+#include "OrderScope.hpp"
+#include "OrderSide.hpp"
+#include "TimeAndSale.hpp"
+
+namespace dxf {
+
+// The allocator of the columns: the arrays are aligned to the cache line
+template <typename T>
+struct ColumnAllocator {
+  static constexpr std::size_t ALIGNMENT = 64;
+
+  using value_type = T;
+
+  ColumnAllocator() = default;
+
+  template <typename U>
+  ColumnAllocator(const ColumnAllocator<U>&) {}  // NOLINT(google-explicit-constructor)
+
+  T* allocate(std::size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), std::align_val_t{ALIGNMENT})); }
+
+  void deallocate(T* p, std::size_t) { ::operator delete(p, std::align_val_t{ALIGNMENT}); }
+
+  template <typename U>
+  bool operator==(const ColumnAllocator<U>&) const {
+    return true;
+  }
+};
+
+template <typename T>
+using Column = std::vector<T, ColumnAllocator<T>>;
+
+// The aggregates of the trades of the time range (see TimeAndSaleColumns::aggregate)
+struct TimeAndSaleAggregates {
+  // The number of the trades
+  std::size_t count = 0;
+
+  // The total size of the trades
+  double volume = 0.0;
+
+  // The sum of price * size of the trades
+  double notional = 0.0;
+
+  // The min and the max prices (NaN if there are no trades)
+  double minPrice = std::numeric_limits<double>::quiet_NaN();
+  double maxPrice = std::numeric_limits<double>::quiet_NaN();
+
+  // The volume-weighted average price or NaN if there are no trades
+  [[nodiscard]] double getVwap() const {
+    return volume > 0.0 ? notional / volume : std::numeric_limits<double>::quiet_NaN();
+  }
+};
+
+/*
+ * The trades of one symbol in the columns (the structure of arrays): the scans of the prices, the sizes or the times
+ * read only the columns they need. The strings are dictionary-encoded: the columns keep the 32-bit ids of the strings
+ * of the container's dictionary (the id 0 is the empty string, see getString).
+ *
+ * The rows are kept in the order of the appends.
+ */
+class TimeAndSaleColumns final {
+  // The independent accumulators of the reductions: the loops are unrolled by them (and vectorized by the compiler)
+  static constexpr std::size_t LANES = 4;
+
+  InternedString eventSymbol_;
+  Column<std::uint64_t> times_;
+  Column<std::uint64_t> indices_;
+  Column<double> prices_;
+  Column<double> sizes_;
+  Column<double> bidPrices_;
+  Column<double> askPrices_;
+  Column<std::uint32_t> eventFlags_;
+  Column<std::int32_t> flags_;
+  Column<OrderSide> sides_;
+  Column<TimeAndSaleType> types_;
+  Column<OrderScope> scopes_;
+  Column<char> exchangeCodes_;
+  Column<std::uint32_t> exchangeSaleConditionIds_;
+  Column<std::uint32_t> buyerIds_;
+  Column<std::uint32_t> sellerIds_;
+  std::vector<InternedString> strings_;
+  // The address of the interned string -> the id
+  FlatHashMap<std::uintptr_t, std::uint32_t> stringIds_;
+
+  std::uint32_t encode(const InternedString& s) {
+    auto key = reinterpret_cast<std::uintptr_t>(&s.get());
+
+    if (const auto* id = stringIds_.find(key)) return *id;
+
+    auto id = static_cast<std::uint32_t>(strings_.size());
+
+    strings_.push_back(s);
+    stringIds_[key] = id;
+
+    return id;
+  }
+
+ public:
+  explicit TimeAndSaleColumns(InternedString eventSymbol)
+      : eventSymbol_{eventSymbol},
+        times_{},
+        indices_{},
+        prices_{},
+        sizes_{},
+        bidPrices_{},
+        askPrices_{},
+        eventFlags_{},
+        flags_{},
+        sides_{},
+        types_{},
+        scopes_{},
+        exchangeCodes_{},
+        exchangeSaleConditionIds_{},
+        buyerIds_{},
+        sellerIds_{},
+        strings_{},
+        stringIds_{} {
+    encode(InternedString{});
+  }
+
+  explicit TimeAndSaleColumns(const std::string& eventSymbol) : TimeAndSaleColumns{InternedString{eventSymbol}} {}
+
+  [[nodiscard]] const std::string& getEventSymbol() const { return eventSymbol_.get(); }
+
+  [[nodiscard]] std::size_t size() const { return times_.size(); }
+
+  [[nodiscard]] bool empty() const { return times_.empty(); }
+
+  void reserve(std::size_t size) {
+    times_.reserve(size);
+    indices_.reserve(size);
+    prices_.reserve(size);
+    sizes_.reserve(size);
+    bidPrices_.reserve(size);
+    askPrices_.reserve(size);
+    eventFlags_.reserve(size);
+    flags_.reserve(size);
+    sides_.reserve(size);
+    types_.reserve(size);
+    scopes_.reserve(size);
+    exchangeCodes_.reserve(size);
+    exchangeSaleConditionIds_.reserve(size);
+    buyerIds_.reserve(size);
+    sellerIds_.reserve(size);
+  }
+
+  // Removes the rows, keeps the dictionary and the capacity
+  void clear() {
+    times_.clear();
+    indices_.clear();
+    prices_.clear();
+    sizes_.clear();
+    bidPrices_.clear();
+    askPrices_.clear();
+    eventFlags_.clear();
+    flags_.clear();
+    sides_.clear();
+    types_.clear();
+    scopes_.clear();
+    exchangeCodes_.clear();
+    exchangeSaleConditionIds_.clear();
+    buyerIds_.clear();
+    sellerIds_.clear();
+  }
+
+  void append(const TimeAndSale& timeAndSale) {
+    times_.push_back(timeAndSale.getTime());
+    indices_.push_back(timeAndSale.getIndex());
+    prices_.push_back(timeAndSale.getPrice());
+    sizes_.push_back(timeAndSale.getSize());
+    bidPrices_.push_back(timeAndSale.getBidPrice());
+    askPrices_.push_back(timeAndSale.getAskPrice());
+    eventFlags_.push_back(timeAndSale.getEventFlags());
+    flags_.push_back(timeAndSale.getFlags());
+    sides_.push_back(timeAndSale.getSide());
+    types_.push_back(timeAndSale.getType());
+    scopes_.push_back(timeAndSale.getScope());
+    exchangeCodes_.push_back(timeAndSale.getExchangeCode());
+    exchangeSaleConditionIds_.push_back(encode(InternedString{timeAndSale.getExchangeSaleConditions()}));
+    buyerIds_.push_back(encode(InternedString{timeAndSale.getBuyer()}));
+    sellerIds_.push_back(encode(InternedString{timeAndSale.getSeller()}));
+  }
+
+  // Appends the C API trade (the strings are interned and encoded, see StringTable)
+  void append(const dxf_time_and_sale_t& tns) {
+    times_.push_back(static_cast<std::uint64_t>(tns.time));
+    indices_.push_back(static_cast<std::uint64_t>(tns.index));
+    prices_.push_back(tns.price);
+    sizes_.push_back(tns.size);
+    bidPrices_.push_back(tns.bid_price);
+    askPrices_.push_back(tns.ask_price);
+    eventFlags_.push_back(tns.event_flags);
+    flags_.push_back(tns.raw_flags);
+    sides_.push_back(static_cast<OrderSide>(tns.side));
+    types_.push_back(static_cast<TimeAndSaleType>(tns.type));
+    scopes_.push_back(static_cast<OrderScope>(tns.scope));
+    exchangeCodes_.push_back(StringConverter::wCharToUtf8(tns.exchange_code));
+    exchangeSaleConditionIds_.push_back(encode(InternedString{tns.exchange_sale_conditions}));
+    buyerIds_.push_back(encode(InternedString{tns.buyer}));
+    sellerIds_.push_back(encode(InternedString{tns.seller}));
+  }
+
+  // Returns the row as the TimeAndSale
+  [[nodiscard]] TimeAndSale get(std::size_t i) const {
+    TimeAndSale result{eventSymbol_};
+
+    result.setTime(times_[i]);
+    result.setIndex(indices_[i]);
+    result.setPrice(prices_[i]);
+    result.setSize(sizes_[i]);
+    result.setBidPrice(bidPrices_[i]);
+    result.setAskPrice(askPrices_[i]);
+    result.setEventFlags(eventFlags_[i]);
+    result.setFlags(flags_[i]);
+    result.setSide(sides_[i]);
+    result.setType(types_[i]);
+    result.setScope(scopes_[i]);
+    result.setExchangeCode(exchangeCodes_[i]);
+    result.setExchangeSaleConditions(getString(exchangeSaleConditionIds_[i]));
+    result.setBuyer(getString(buyerIds_[i]));
+    result.setSeller(getString(sellerIds_[i]));
+
+    return result;
+  }
+
+  // Returns the string of the dictionary by the id
+  [[nodiscard]] const std::string& getString(std::uint32_t id) const { return strings_[id].get(); }
+
+  // The number of the distinct strings of the dictionary (with the empty string)
+  [[nodiscard]] std::size_t getStringsNumber() const { return strings_.size(); }
+
+  [[nodiscard]] std::span<const std::uint64_t> getTimes() const { return times_; }
+
+  [[nodiscard]] std::span<const std::uint64_t> getIndices() const { return indices_; }
+
+  [[nodiscard]] std::span<const double> getPrices() const { return prices_; }
+
+  [[nodiscard]] std::span<const double> getSizes() const { return sizes_; }
+
+  [[nodiscard]] std::span<const double> getBidPrices() const { return bidPrices_; }
+
+  [[nodiscard]] std::span<const double> getAskPrices() const { return askPrices_; }
+
+  [[nodiscard]] std::span<const std::uint32_t> getEventFlags() const { return eventFlags_; }
+
+  [[nodiscard]] std::span<const std::int32_t> getFlags() const { return flags_; }
+
+  [[nodiscard]] std::span<const OrderSide> getSides() const { return sides_; }
+
+  [[nodiscard]] std::span<const TimeAndSaleType> getTypes() const { return types_; }
+
+  [[nodiscard]] std::span<const OrderScope> getScopes() const { return scopes_; }
+
+  [[nodiscard]] std::span<const char> getExchangeCodes() const { return exchangeCodes_; }
+
+  [[nodiscard]] std::span<const std::uint32_t> getExchangeSaleConditionIds() const {
+    return exchangeSaleConditionIds_;
+  }
+
+  [[nodiscard]] std::span<const std::uint32_t> getBuyerIds() const { return buyerIds_; }
+
+  [[nodiscard]] std::span<const std::uint32_t> getSellerIds() const { return sellerIds_; }
+
+  /*
+   * Returns the count, the volume, the notional (so the VWAP) and the min and max prices of the trades with the time in
+   * [fromTime, toTime). The trades with the non-positive or NaN sizes are skipped. The rows do not need to be sorted
+   * by the time: the loop reads all the times, prices and sizes without the branches.
+   */
+  [[nodiscard]] TimeAndSaleAggregates aggregate(
+    std::uint64_t fromTime = 0, std::uint64_t toTime = std::numeric_limits<std::uint64_t>::max()) const {
+    const auto* times = times_.data();
+    const auto* prices = prices_.data();
+    const auto* sizes = sizes_.data();
+    const auto n = size();
+
+    std::size_t count[LANES]{};
+    double volume[LANES]{};
+    double notional[LANES]{};
+    double minPrice[LANES];
+    double maxPrice[LANES];
+
+    std::fill(std::begin(minPrice), std::end(minPrice), std::numeric_limits<double>::infinity());
+    std::fill(std::begin(maxPrice), std::end(maxPrice), -std::numeric_limits<double>::infinity());
+
+    auto accumulate = [&](std::size_t lane, std::size_t i) {
+      bool selected = times[i] >= fromTime && times[i] < toTime && sizes[i] > 0.0;
+
+      count[lane] += selected ? 1 : 0;
+      volume[lane] += selected ? sizes[i] : 0.0;
+      notional[lane] += selected ? prices[i] * sizes[i] : 0.0;
+      minPrice[lane] = selected && prices[i] < minPrice[lane] ? prices[i] : minPrice[lane];
+      maxPrice[lane] = selected && prices[i] > maxPrice[lane] ? prices[i] : maxPrice[lane];
+    };
+
+    std::size_t i = 0;
+
+    for (; i + LANES <= n; i += LANES) {
+      for (std::size_t lane = 0; lane < LANES; lane++) accumulate(lane, i + lane);
+    }
+
+    for (; i < n; i++) accumulate(0, i);
+
+    TimeAndSaleAggregates result{};
+
+    for (std::size_t lane = 0; lane < LANES; lane++) {
+      result.count += count[lane];
+      result.volume += volume[lane];
+      result.notional += notional[lane];
+      result.minPrice = lane == 0 ? minPrice[0] : (std::min)(result.minPrice, minPrice[lane]);
+      result.maxPrice = lane == 0 ? maxPrice[0] : (std::max)(result.maxPrice, maxPrice[lane]);
+    }
+
+    if (result.count == 0) {
+      result.minPrice = std::numeric_limits<double>::quiet_NaN();
+      result.maxPrice = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    return result;
+  }
+};
+
+}  // namespace dxf
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <DXFeed.h>
+
+#include <cstdint>
+#include <string>
+
+#include "IndexedEvent.hpp"
+#include "InternedString.hpp"
+#include "OrderScope.hpp"
+#include "OrderSide.hpp"
+#include "StringConverter.hpp"
+#include "TimeAndSale.hpp"
+
+namespace dxf {
+
+/*
+ * The read-only non-owning view of the C API trade with the TimeAndSale getters. The numbers are read directly from
+ * the C struct, the strings are converted (interned, see StringTable) only by their getters. The view is valid only
+ * while the struct and the symbol are: in the listener callback. `materialize` makes the owning TimeAndSale.
+ */
+class TimeAndSaleView final {
+  dxf_const_string_t eventSymbol_;
+  const dxf_time_and_sale_t* tns_;
+
+ public:
+  TimeAndSaleView(dxf_const_string_t eventSymbol, const dxf_time_and_sale_t& tns)
+      : eventSymbol_{eventSymbol}, tns_{&tns} {}
+
+  [[nodiscard]] TimeAndSale materialize() const { return TimeAndSale{InternedString{eventSymbol_}, *tns_}; }
+
+  [[nodiscard]] const dxf_time_and_sale_t& getData() const { return *tns_; }
+
+  [[nodiscard]] const std::string& getEventSymbol() const { return *StringTable::getInstance().intern(eventSymbol_); }
+
+  // The C API trade has no event time
+  [[nodiscard]] std::uint64_t getEventTime() const { return 0; }
+
+  [[nodiscard]] const IndexedEventSource& getSource() const { return IndexedEventSource::DEFAULT; }
+
+  [[nodiscard]] std::uint32_t getEventFlags() const { return tns_->event_flags; }
+
+  [[nodiscard]] std::uint64_t getIndex() const { return static_cast<std::uint64_t>(tns_->index); }
+
+  [[nodiscard]] std::uint64_t getTime() const { return static_cast<std::uint64_t>(tns_->time); }
+
+  [[nodiscard]] char getExchangeCode() const { return StringConverter::wCharToUtf8(tns_->exchange_code); }
+
+  [[nodiscard]] double getPrice() const { return tns_->price; }
+
+  [[nodiscard]] double getSize() const { return tns_->size; }
+
+  [[nodiscard]] double getBidPrice() const { return tns_->bid_price; }
+
+  [[nodiscard]] double getAskPrice() const { return tns_->ask_price; }
+
+  [[nodiscard]] const std::string& getExchangeSaleConditions() const {
+    return *StringTable::getInstance().intern(tns_->exchange_sale_conditions);
+  }
+
+  [[nodiscard]] std::int32_t getFlags() const { return tns_->raw_flags; }
+
+  [[nodiscard]] const std::string& getBuyer() const { return *StringTable::getInstance().intern(tns_->buyer); }
+
+  [[nodiscard]] const std::string& getSeller() const { return *StringTable::getInstance().intern(tns_->seller); }
+
+  [[nodiscard]] OrderSide getSide() const { return static_cast<OrderSide>(tns_->side); }
+
+  [[nodiscard]] TimeAndSaleType getType() const { return static_cast<TimeAndSaleType>(tns_->type); }
+
+  [[nodiscard]] bool isValidTick1() const { return static_cast<bool>(tns_->is_valid_tick); }
+
+  [[nodiscard]] bool isEthTrade1() const { return static_cast<bool>(tns_->is_eth_trade); }
+
+  [[nodiscard]] char getTradeThroughExempt() const { return StringConverter::wCharToUtf8(tns_->trade_through_exempt); }
+
+  [[nodiscard]] bool isSpreadLeg1() const { return static_cast<bool>(tns_->is_spread_leg); }
+
+  [[nodiscard]] OrderScope getScope() const { return static_cast<OrderScope>(tns_->scope); }
+};
+
+}  // namespace dxf
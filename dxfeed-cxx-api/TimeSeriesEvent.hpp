@@ -4,9 +4,17 @@
 
 namespace dxf {
 
-template <typename SymbolType>
-struct TimeSeriesEvent : public virtual IndexedEvent<SymbolType> {
-  IndexedEventSource getSource() override { return IndexedEventSource::DEFAULT; }
+// The event of the time series: the indexed event of the DEFAULT source
+template <typename Event>
+concept TimeSeriesEventType = IndexedEventType<Event> && requires(const Event& event) {
+  { event.getTime() } -> std::convertible_to<std::uint64_t>;
 };
 
-}
\ No newline at end of file
+// The CRTP mixin of the time series events
+template <typename Event>
+class TimeSeriesEvent : public IndexedEvent<Event> {
+ protected:
+  TimeSeriesEvent() = default;
+};
+
+}  // namespace dxf
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+/*
+ * The heap allocations counter of the benchmark tools. It replaces all the forms of the global operator new and delete
+ * (the plain, array, aligned and nothrow ones) with the single counting allocation pair, so the allocations of the
+ * standard containers and the aligned ones are counted the same way and the matching deallocations free them.
+ *
+ * The replacement functions can not be inline: the header must be included by one translation unit of the tool.
+ */
+
+// The number of the allocations since the start of the program
+std::atomic<std::size_t> allocationsNumber{0};
+
+void* countedAllocate(std::size_t size, std::size_t alignment) noexcept {
+  allocationsNumber.fetch_add(1, std::memory_order_relaxed);
+
+  if (size == 0) size = 1;
+
+  if (alignment <= alignof(std::max_align_t)) return std::malloc(size);
+
+#ifdef _MSC_VER
+  return _aligned_malloc(size, alignment);
+#else
+  return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#endif
+}
+
+void countedFree(void* p, std::size_t alignment) noexcept {
+#ifdef _MSC_VER
+  if (alignment > alignof(std::max_align_t)) {
+    _aligned_free(p);
+
+    return;
+  }
+#else
+  (void)alignment;
+#endif
+
+  std::free(p);
+}
+
+void* countedAllocateOrThrow(std::size_t size, std::size_t alignment) {
+  if (auto* p = countedAllocate(size, alignment)) return p;
+
+  throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size) { return countedAllocateOrThrow(size, 0); }
+
+void* operator new[](std::size_t size) { return countedAllocateOrThrow(size, 0); }
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return countedAllocateOrThrow(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size, 0); }
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return countedAllocate(size, 0); }
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p) noexcept { countedFree(p, 0); }
+
+void operator delete[](void* p) noexcept { countedFree(p, 0); }
+
+void operator delete(void* p, std::size_t) noexcept { countedFree(p, 0); }
+
+void operator delete[](void* p, std::size_t) noexcept { countedFree(p, 0); }
+
+void operator delete(void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept { countedFree(p, 0); }
+
+void operator delete(void* p, std::align_val_t alignment) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* p, std::size_t, std::align_val_t alignment) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
+
+void operator delete[](void* p, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+  countedFree(p, static_cast<std::size_t>(alignment));
+}
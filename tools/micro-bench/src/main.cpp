@@ -0,0 +1,423 @@
+#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING 1
+
+#include <DXFeed.h>
+#include <fmt/format.h>
+
+#include <AllocationCounter.hpp>
+#include <PriceLevelBook.hpp>
+#include <StringConverter.hpp>
+#include <TimeAndSale.hpp>
+#include <TimeAndSaleColumns.hpp>
+#include <TimeAndSaleView.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+volatile double sink = 0.0;
+
+struct OrderFlow {
+  // The orders of the snapshot: one order per price level, `depth` levels per side
+  std::vector<dxf_order_t> snapshot{};
+  std::vector<dxf_order_t> updates{};
+};
+
+/*
+ * Generates the reproducible order flow around a slowly drifting mid price. Every update cancels a random resting
+ * order with the probability `cancelRatio`. Otherwise, it changes the size of a resting order (1/4) or adds a new order
+ * at a random level within the depth.
+ */
+OrderFlow generateOrderFlow(std::size_t updatesNumber, std::size_t depth, double cancelRatio, double tickSize,
+                            std::uint64_t seed) {
+  std::mt19937_64 rng{seed};
+  std::uniform_int_distribution<std::int64_t> offsetDistribution{1, static_cast<std::int64_t>(depth)};
+  std::uniform_int_distribution<int> sizeDistribution{1, 10};
+  std::uniform_real_distribution<double> probabilityDistribution{0.0, 1.0};
+  OrderFlow result{};
+  std::vector<dxf_order_t> resting{};
+  dxf_long_t nextIndex = 0;
+
+  auto makeOrder = [&](std::int64_t midTicks, dxf_long_t time) {
+    dxf_order_t order{};
+    auto isBid = (rng() & 1U) != 0;
+    auto offset = offsetDistribution(rng);
+
+    order.index = nextIndex++;
+    order.time = time;
+    order.price = static_cast<double>(isBid ? midTicks - offset : midTicks + offset) * tickSize;
+    order.size = sizeDistribution(rng);
+    order.side = isBid ? dxf_osd_buy : dxf_osd_sell;
+
+    return order;
+  };
+
+  for (std::size_t level = 1; level <= depth; level++) {
+    for (auto side : {dxf_osd_buy, dxf_osd_sell}) {
+      dxf_order_t order{};
+      auto ticks = static_cast<std::int64_t>(level);
+
+      order.index = nextIndex++;
+      order.price = static_cast<double>(side == dxf_osd_buy ? 100000 - ticks : 100000 + ticks) * tickSize;
+      order.size = sizeDistribution(rng);
+      order.side = side;
+      result.snapshot.push_back(order);
+    }
+  }
+
+  if (!result.snapshot.empty()) {
+    result.snapshot.front().event_flags |= dxf_ef_snapshot_begin;
+    result.snapshot.back().event_flags |= dxf_ef_snapshot_end;
+  }
+
+  resting = result.snapshot;
+  result.updates.reserve(updatesNumber);
+
+  for (std::size_t i = 0; i < updatesNumber; i++) {
+    auto midTicks = std::llround(100000.0 + 100.0 * std::sin(static_cast<double>(i) / 100000.0));
+    auto time = static_cast<dxf_long_t>(i);
+    auto probability = probabilityDistribution(rng);
+
+    if (!resting.empty() && probability < cancelRatio) {
+      auto position = static_cast<std::size_t>(rng() % resting.size());
+      auto order = resting[position];
+
+      order.event_flags = dxf_ef_remove_event;
+      order.size = 0;
+      order.time = time;
+      result.updates.push_back(order);
+      resting[position] = resting.back();
+      resting.pop_back();
+    } else if (!resting.empty() && probability < cancelRatio + (1.0 - cancelRatio) / 4.0) {
+      auto& order = resting[static_cast<std::size_t>(rng() % resting.size())];
+
+      order.event_flags = 0;
+      order.size = sizeDistribution(rng);
+      order.time = time;
+      result.updates.push_back(order);
+    } else {
+      auto order = makeOrder(midTicks, time);
+
+      result.updates.push_back(order);
+      resting.push_back(order);
+    }
+  }
+
+  return result;
+}
+
+// Generates the reproducible trades: the random walk of the price, the exchange codes, the sale conditions and the
+// market makers from the small sets (the strings are static)
+std::vector<dxf_time_and_sale_t> generateTimeAndSales(std::size_t eventsNumber, double tickSize, std::uint64_t seed) {
+  static const wchar_t* const SALE_CONDITIONS[] = {L"", L"T", L"@ TI", L"FT", L"@4 W"};
+  static const wchar_t* const MARKET_MAKERS[] = {L"", L"NSDQ", L"GSCO", L"MSCO", L"JPMS", L"CDRG"};
+  static const wchar_t EXCHANGE_CODES[] = L"QNPZKXVJ";
+
+  std::mt19937_64 rng{seed};
+  std::uniform_int_distribution<int> stepDistribution{-2, 2};
+  std::uniform_int_distribution<int> sizeDistribution{1, 500};
+  std::vector<dxf_time_and_sale_t> result(eventsNumber);
+  std::int64_t priceTicks = 10000;
+
+  for (std::size_t i = 0; i < eventsNumber; i++) {
+    auto& tns = result[i];
+
+    priceTicks = (std::max)(std::int64_t{1}, priceTicks + stepDistribution(rng));
+    tns.index = static_cast<dxf_long_t>(i);
+    tns.time = 1600000000000 + static_cast<dxf_long_t>(i);
+    tns.exchange_code = EXCHANGE_CODES[rng() % (std::size(EXCHANGE_CODES) - 1)];
+    tns.price = static_cast<double>(priceTicks) * tickSize;
+    tns.size = sizeDistribution(rng);
+    tns.bid_price = tns.price - tickSize;
+    tns.ask_price = tns.price + tickSize;
+    tns.exchange_sale_conditions = SALE_CONDITIONS[rng() % std::size(SALE_CONDITIONS)];
+    tns.raw_flags = static_cast<dxf_int_t>(rng() & 0xFFU);
+    tns.buyer = MARKET_MAKERS[rng() % std::size(MARKET_MAKERS)];
+    tns.seller = MARKET_MAKERS[rng() % std::size(MARKET_MAKERS)];
+    tns.side = (rng() & 1U) != 0 ? dxf_osd_buy : dxf_osd_sell;
+    tns.type = rng() % 100 == 0 ? dxf_tnst_correction : dxf_tnst_new;
+    tns.is_valid_tick = 1;
+    tns.trade_through_exempt = L'X';
+    tns.scope = dxf_osc_composite;
+  }
+
+  return result;
+}
+
+// Generates the reproducible stock and option symbols
+std::vector<std::string> generateSymbols(std::size_t symbolsNumber, std::uint64_t seed) {
+  std::mt19937_64 rng{seed};
+  std::vector<std::string> result{};
+
+  result.reserve(symbolsNumber);
+
+  for (std::size_t i = 0; i < symbolsNumber; i++) {
+    std::string root(1 + rng() % 4, 'A');
+
+    for (auto& c : root) c = static_cast<char>('A' + rng() % 26);
+
+    if (i % 2 == 0) {
+      result.push_back(root);
+    } else {
+      result.push_back(fmt::format(".{}{:02}{:02}{:02}{}{}", root, 20 + rng() % 10, 1 + rng() % 12, 1 + rng() % 28,
+                                   (rng() & 1U) != 0 ? 'C' : 'P', 10 + rng() % 500));
+    }
+  }
+
+  return result;
+}
+
+/*
+ * Measures the best of the runs: every run calls the prepare() (not measured) and then the run(prepared) that
+ * performs the `operationsNumber` operations. Prints ns and heap allocations per operation.
+ */
+template <typename Prepare, typename Run>
+void runBenchmark(const std::string& name, std::size_t operationsNumber, Prepare&& prepare, Run&& run) {
+  const std::size_t runsNumber = 3;
+  double nsPerOperation = 0.0;
+  double allocationsPerOperation = 0.0;
+  auto operations = static_cast<double>((std::max)(operationsNumber, std::size_t{1}));
+
+  for (std::size_t r = 0; r < runsNumber; r++) {
+    auto prepared = prepare();
+    auto allocationsBefore = allocationsNumber.load();
+    auto start = std::chrono::steady_clock::now();
+
+    run(prepared);
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    auto runNsPerOperation = static_cast<double>(elapsed.count()) / operations;
+
+    if (r == 0 || runNsPerOperation < nsPerOperation) {
+      nsPerOperation = runNsPerOperation;
+      allocationsPerOperation = static_cast<double>(allocationsNumber.load() - allocationsBefore) / operations;
+    }
+  }
+
+  fmt::print("{:<32} {:>12.1f} {:>14.4f}\n", name, nsPerOperation, allocationsPerOperation);
+}
+
+// Feeds the orders to the book by the snapshot data of `batchSize` orders
+void feed(dxf::PriceLevelBook& book, const std::vector<dxf_order_t>& orders, std::size_t batchSize,
+          bool isNewSnapshot) {
+  dxf_snapshot_data_t snapshotData{};
+
+  for (std::size_t i = 0; i < orders.size(); i += batchSize) {
+    snapshotData.records_count = (std::min)(batchSize, orders.size() - i);
+    snapshotData.records = orders.data() + i;
+    book.processSnapshotData(&snapshotData, isNewSnapshot && i == 0 ? 1 : 0);
+  }
+}
+
+// The snapshot and the order flow through the book (not subscribed) of the ladder type
+void runPriceLevelBook(const std::string& name, dxf::PriceLevelLadderType ladderType, const OrderFlow& orderFlow,
+                       std::size_t levelsNumber, double tickSize, std::size_t batchSize) {
+  dxf::PriceLevelBookOptions options{};
+
+  options.ladderType = ladderType;
+  options.tickSize = tickSize;
+
+  auto makeBook = [&] { return dxf::PriceLevelBook::create(nullptr, "BENCH", "NTV", levelsNumber, options); };
+
+  runBenchmark(fmt::format("PriceLevelBook {} snapshot", name), orderFlow.snapshot.size(), makeBook,
+               [&](auto& book) { feed(*book, orderFlow.snapshot, orderFlow.snapshot.size(), true); });
+
+  runBenchmark(
+    fmt::format("PriceLevelBook {} orders", name), orderFlow.updates.size(),
+    [&] {
+      auto book = makeBook();
+
+      feed(*book, orderFlow.snapshot, orderFlow.snapshot.size(), true);
+
+      return book;
+    },
+    [&](auto& book) {
+      feed(*book, orderFlow.updates, batchSize, false);
+      sink = book->getAnalytics().bids.size;
+    });
+}
+
+void runTimeAndSale(const std::vector<dxf_time_and_sale_t>& timeAndSales) {
+  const std::string symbol = "AAPL";
+  const std::wstring wSymbol = L"AAPL";
+
+  runBenchmark(
+    "TimeAndSale construct", timeAndSales.size(), [] { return 0; },
+    [&](int) {
+      double checksum = 0.0;
+
+      for (const auto& tns : timeAndSales) {
+        dxf::TimeAndSale timeAndSale{symbol, tns};
+
+        checksum += timeAndSale.getPrice();
+      }
+
+      sink = checksum;
+    });
+
+  // As the SimpleTimeAndSaleDataProvider keeps them
+  runBenchmark(
+    "TimeAndSale construct + store", timeAndSales.size(),
+    [&] {
+      std::vector<dxf::TimeAndSale> events{};
+
+      events.reserve(timeAndSales.size());
+
+      return events;
+    },
+    [&](auto& events) {
+      for (const auto& tns : timeAndSales) events.emplace_back(symbol, tns);
+
+      sink = static_cast<double>(events.size());
+    });
+
+  // The listeners that read only the numbers
+  runBenchmark(
+    "TimeAndSaleView read", timeAndSales.size(), [] { return 0; },
+    [&](int) {
+      double checksum = 0.0;
+
+      for (const auto& tns : timeAndSales) {
+        dxf::TimeAndSaleView view{wSymbol.c_str(), tns};
+
+        checksum += view.getPrice() * view.getSize() + static_cast<double>(view.getTime());
+      }
+
+      sink = checksum;
+    });
+
+  runBenchmark(
+    "TimeAndSaleView materialize", timeAndSales.size(), [] { return 0; },
+    [&](int) {
+      double checksum = 0.0;
+
+      for (const auto& tns : timeAndSales) {
+        auto timeAndSale = dxf::TimeAndSaleView{wSymbol.c_str(), tns}.materialize();
+
+        checksum += timeAndSale.getPrice();
+      }
+
+      sink = checksum;
+    });
+
+  runBenchmark(
+    "TimeAndSaleColumns append", timeAndSales.size(),
+    [&] {
+      dxf::TimeAndSaleColumns columns{symbol};
+
+      columns.reserve(timeAndSales.size());
+
+      return columns;
+    },
+    [&](auto& columns) {
+      for (const auto& tns : timeAndSales) columns.append(tns);
+
+      sink = static_cast<double>(columns.size());
+    });
+
+  // The VWAP of the middle half of the trades: the array of the events vs the columns
+  std::vector<dxf::TimeAndSale> events{};
+  dxf::TimeAndSaleColumns columns{symbol};
+
+  for (const auto& tns : timeAndSales) {
+    events.emplace_back(symbol, tns);
+    columns.append(tns);
+  }
+
+  auto fromTime = timeAndSales.empty() ? 0 : timeAndSales.front().time + timeAndSales.size() / 4;
+  auto toTime = fromTime + timeAndSales.size() / 2;
+
+  runBenchmark(
+    "TimeAndSale vector VWAP", timeAndSales.size(), [] { return 0; },
+    [&](int) {
+      double volume = 0.0;
+      double notional = 0.0;
+
+      for (const auto& event : events) {
+        if (event.getTime() >= fromTime && event.getTime() < toTime && event.getSize() > 0.0) {
+          volume += event.getSize();
+          notional += event.getPrice() * event.getSize();
+        }
+      }
+
+      sink = notional / volume;
+    });
+
+  runBenchmark(
+    "TimeAndSaleColumns VWAP", timeAndSales.size(), [] { return 0; },
+    [&](int) { sink = columns.aggregate(fromTime, toTime).getVwap(); });
+}
+
+void runStringConverter(const std::vector<std::string>& symbols, const std::vector<dxf_time_and_sale_t>& timeAndSales) {
+  std::vector<std::wstring> wSymbols{};
+
+  for (const auto& symbol : symbols) wSymbols.push_back(dxf::StringConverter::utf8ToWString(symbol));
+
+  runBenchmark(
+    "StringConverter utf8ToWString", symbols.size(), [] { return 0; },
+    [&](int) {
+      std::size_t checksum = 0;
+
+      for (const auto& symbol : symbols) checksum += dxf::StringConverter::utf8ToWString(symbol).size();
+
+      sink = static_cast<double>(checksum);
+    });
+
+  runBenchmark(
+    "StringConverter wStringToUtf8", wSymbols.size(), [] { return 0; },
+    [&](int) {
+      std::size_t checksum = 0;
+
+      for (const auto& wSymbol : wSymbols) checksum += dxf::StringConverter::wStringToUtf8(wSymbol).size();
+
+      sink = static_cast<double>(checksum);
+    });
+
+  runBenchmark(
+    "StringConverter wCharToUtf8", timeAndSales.size(), [] { return 0; },
+    [&](int) {
+      std::size_t checksum = 0;
+
+      for (const auto& tns : timeAndSales) {
+        checksum += static_cast<std::size_t>(dxf::StringConverter::wCharToUtf8(tns.exchange_code));
+      }
+
+      sink = static_cast<double>(checksum);
+    });
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+    std::cout << "Usage:\n  micro-bench [<number of operations> [<book depth> [<cancel ratio> [<seed>]]]]\n\n";
+
+    return 0;
+  }
+
+  std::size_t operationsNumber = argc > 1 ? std::stoull(argv[1]) : 1000000;
+  std::size_t depth = argc > 2 ? std::stoull(argv[2]) : 100;
+  double cancelRatio = argc > 3 ? std::stod(argv[3]) : 0.4;
+  std::uint64_t seed = argc > 4 ? std::stoull(argv[4]) : 42;
+  const double tickSize = 0.01;
+  const std::size_t levelsNumber = 10;
+  const std::size_t batchSize = 4;
+
+  auto orderFlow = generateOrderFlow(operationsNumber, depth, cancelRatio, tickSize, seed);
+  auto timeAndSales = generateTimeAndSales(operationsNumber, tickSize, seed);
+  auto symbols = generateSymbols(operationsNumber, seed);
+
+  fmt::print("Operations: {}, depth: {}, cancel ratio: {}, seed: {}, levels: {}, batch: {}\n", operationsNumber, depth,
+             cancelRatio, seed, levelsNumber, batchSize);
+  fmt::print("{:<32} {:>12} {:>14}\n", "Benchmark", "ns/op", "allocs/op");
+
+  runPriceLevelBook("ORDERED", dxf::PriceLevelLadderType::ORDERED, orderFlow, levelsNumber, tickSize, batchSize);
+  runPriceLevelBook("TICK", dxf::PriceLevelLadderType::TICK, orderFlow, levelsNumber, tickSize, batchSize);
+  runPriceLevelBook("SHALLOW", dxf::PriceLevelLadderType::SHALLOW, orderFlow, levelsNumber, tickSize, batchSize);
+  runTimeAndSale(timeAndSales);
+  runStringConverter(symbols, timeAndSales);
+
+  return 0;
+}
@@ -0,0 +1,824 @@
+#define _SILENCE_CXX17_CODECVT_HEADER_DEPRECATION_WARNING 1
+
+#include <fmt/format.h>
+
+#include <AllocationCounter.hpp>
+#include <FlatHashMap.hpp>
+#include <PriceLevelBook.hpp>
+#include <PriceLevelBookCore.hpp>
+#include <PriceLevelLadder.hpp>
+#include <PriceLevelTopPublisher.hpp>
+#include <PriceSearch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+volatile double sink = 0.0;
+
+template <typename Number>
+struct LevelUpdate {
+  dxf::PriceLevelSide side;
+  Number price;
+
+  // 0 - remove the price level
+  Number size;
+};
+
+// Generates the reproducible stream of the price level updates around a slowly drifting mid price.
+std::vector<LevelUpdate<double>> generateUpdates(std::size_t updatesNumber, std::size_t depth, double tickSize,
+                                                 std::uint64_t seed) {
+  std::mt19937_64 rng{seed};
+  std::uniform_int_distribution<std::size_t> depthDistribution{1, depth};
+  std::uniform_int_distribution<int> sizeDistribution{0, 9};
+  std::vector<LevelUpdate<double>> result{};
+
+  result.reserve(updatesNumber);
+
+  for (std::size_t i = 0; i < updatesNumber; i++) {
+    auto midTicks = std::llround(100000.0 + 1000.0 * std::sin(static_cast<double>(i) / 100000.0));
+    auto side = (rng() & 1U) != 0 ? dxf::PriceLevelSide::BID : dxf::PriceLevelSide::ASK;
+    auto offset = static_cast<std::int64_t>(depthDistribution(rng));
+    auto ticks = side == dxf::PriceLevelSide::BID ? midTicks - offset : midTicks + offset;
+
+    result.push_back({side, static_cast<double>(ticks) * tickSize, static_cast<double>(sizeDistribution(rng))});
+  }
+
+  return result;
+}
+
+template <typename Numbers>
+std::vector<LevelUpdate<typename Numbers::Number>> convertUpdates(const std::vector<LevelUpdate<double>>& updates,
+                                                                  const Numbers& numbers) {
+  std::vector<LevelUpdate<typename Numbers::Number>> result{};
+
+  result.reserve(updates.size());
+
+  for (const auto& update : updates) {
+    result.push_back({update.side, numbers.toPrice(update.price), numbers.toSize(update.size)});
+  }
+
+  return result;
+}
+
+// Replays the updates in the same way as the PriceLevelBook does: lookup by price, then insert, update or remove the
+// level, then check the visibility bounds (the N-th level lookups)
+template <typename Ladder, typename Number>
+double run(Ladder& asks, Ladder& bids, const std::vector<LevelUpdate<Number>>& updates, std::size_t levelsNumber) {
+  auto start = std::chrono::steady_clock::now();
+  double checksum = 0.0;
+
+  for (std::size_t i = 0; i < updates.size(); i++) {
+    const auto& update = updates[i];
+    auto& ladder = update.side == dxf::PriceLevelSide::BID ? bids : asks;
+    const auto* found = ladder.find(update.price);
+
+    if (levelsNumber != 0 && ladder.size() > levelsNumber) {
+      checksum += ladder[levelsNumber - 1].price + ladder[levelsNumber].price;
+    }
+
+    if (found == nullptr) {
+      if (update.size != 0) {
+        ladder.insert({update.price, update.size, static_cast<std::int64_t>(i)});
+      }
+    } else if (update.size == 0) {
+      ladder.erase(update.price);
+    } else {
+      ladder.update({update.price, update.size, static_cast<std::int64_t>(i)});
+    }
+  }
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+
+  // Keeps the lookups from being optimized out
+  sink = checksum;
+
+  return static_cast<double>(elapsed.count()) / static_cast<double>(updates.size());
+}
+
+template <typename Numbers, typename Level>
+bool areEqual(const Numbers& numbers, const std::vector<dxf::PriceLevel>& levels1, const std::vector<Level>& levels2) {
+  if (levels1.size() != levels2.size()) return false;
+
+  for (std::size_t i = 0; i < levels1.size(); i++) {
+    auto priceLevel = numbers.toPriceLevel(levels2[i]);
+
+    if (std::abs(levels1[i].price - priceLevel.price) > 1e-9 || std::abs(levels1[i].size - priceLevel.size) > 1e-9) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Runs the updates against the ladder and checks the result against the reference (the ORDERED floating point ladder)
+template <typename Numbers, template <typename> class Ladder>
+bool runAndCheck(const std::string& name, const Numbers& numbers, double tickSize,
+                 const std::vector<LevelUpdate<double>>& updates, std::size_t levelsNumber, double referenceNsPerUpdate,
+                 const dxf::OrderedPriceLevelLadder<dxf::PriceLevel>& referenceAsks,
+                 const dxf::OrderedPriceLevelLadder<dxf::PriceLevel>& referenceBids) {
+  using Level = typename Numbers::Level;
+
+  auto convertedUpdates = convertUpdates(updates, numbers);
+  auto asks =
+    dxf::makePriceLevelLadder<Ladder<Level>>(dxf::PriceLevelSide::ASK, numbers.toPrice(tickSize), levelsNumber);
+  auto bids =
+    dxf::makePriceLevelLadder<Ladder<Level>>(dxf::PriceLevelSide::BID, numbers.toPrice(tickSize), levelsNumber);
+
+  auto nsPerUpdate = run(asks, bids, convertedUpdates, levelsNumber);
+  auto isConsistent = areEqual(numbers, referenceAsks.copyTop(0), asks.copyTop(0)) &&
+                      areEqual(numbers, referenceBids.copyTop(0), bids.copyTop(0));
+
+  fmt::print("{:<16} {:>12.1f} {:>10.2f}x {:>8}\n", name, nsPerUpdate, referenceNsPerUpdate / nsPerUpdate,
+             isConsistent ? "OK" : "FAILED");
+
+  return isConsistent;
+}
+
+// Feeds the price far from the book and the price off the tick grid to the TICK ladder between the regular updates:
+// the levels must stay distinct (in the fallback ladder, without growing the array) and the ladder must return to the
+// array when they are removed
+template <typename Numbers>
+bool checkTickOutliers(const std::string& name, const Numbers& numbers, double tickSize,
+                       const std::vector<LevelUpdate<double>>& updates) {
+  using Level = typename Numbers::Level;
+  using Ladder = dxf::TickPriceLevelLadder<Level>;
+
+  auto half = updates.begin() + static_cast<std::ptrdiff_t>((std::min)(updates.size(), std::size_t{100000}) / 2);
+  std::vector<LevelUpdate<double>> head(updates.begin(), half);
+  std::vector<LevelUpdate<double>> tail(half, half + (half - updates.begin()));
+  std::vector<LevelUpdate<double>> outliers = {{dxf::PriceLevelSide::ASK, 100000.0, 5.0},
+                                               {dxf::PriceLevelSide::BID, 999.005, 3.0},
+                                               {dxf::PriceLevelSide::BID, 999.01, 7.0}};
+  std::vector<LevelUpdate<double>> removals = {{dxf::PriceLevelSide::ASK, 100000.0, 0.0},
+                                               {dxf::PriceLevelSide::BID, 999.005, 0.0}};
+
+  dxf::OrderedPriceLevelLadder<dxf::PriceLevel> referenceAsks{dxf::PriceLevelSide::ASK};
+  dxf::OrderedPriceLevelLadder<dxf::PriceLevel> referenceBids{dxf::PriceLevelSide::BID};
+  Ladder asks{dxf::PriceLevelSide::ASK, numbers.toPrice(tickSize)};
+  Ladder bids{dxf::PriceLevelSide::BID, numbers.toPrice(tickSize)};
+
+  auto apply = [&](const std::vector<LevelUpdate<double>>& batch) {
+    run(referenceAsks, referenceBids, batch, 0);
+    run(asks, bids, convertUpdates(batch, numbers), 0);
+
+    return areEqual(numbers, referenceAsks.copyTop(0), asks.copyTop(0)) &&
+           areEqual(numbers, referenceBids.copyTop(0), bids.copyTop(0));
+  };
+
+  auto isConsistent = apply(head) && !asks.isFallback() && !bids.isFallback();
+
+  isConsistent = isConsistent && apply(outliers) && asks.isFallback() && bids.isFallback();
+  isConsistent = isConsistent && apply(removals) && !asks.isFallback() && !bids.isFallback();
+  isConsistent = isConsistent && apply(tail) && !asks.isFallback() && !bids.isFallback();
+
+  fmt::print("{:<32} {:>8}\n", name, isConsistent ? "OK" : "FAILED");
+
+  return isConsistent;
+}
+
+// Feeds the snapshot data callbacks with the transaction and snapshot flags to the book (batchTransactions) and checks
+// its notifications: the new snapshots are applied at once whatever their flags, the incremental updates are applied
+// when their transaction is completed (the last order has no TX_PENDING)
+bool checkTransactions() {
+  std::size_t newBooksNumber = 0;
+  std::size_t changesNumber = 0;
+  std::size_t bidsNumber = 0;
+  auto book = dxf::PriceLevelBook::create(nullptr, "AAPL", "NTV", 0);
+
+  book->setOnNewBook([&](const dxf::PriceLevelChanges& newBook) {
+    newBooksNumber++;
+    bidsNumber = newBook.bids.size();
+  });
+  book->setOnIncrementalChange([&](const dxf::PriceLevelChangesSet& changesSet) {
+    changesNumber++;
+    bidsNumber += changesSet.additions.bids.size();
+    bidsNumber -= changesSet.removals.bids.size();
+  });
+
+  auto makeOrder = [](dxf_long_t index, double price, double size, dxf_event_flags_t flags) {
+    dxf_order_t order{};
+
+    order.event_flags = flags;
+    order.index = index;
+    order.price = price;
+    order.size = size;
+    order.side = dxf_osd_buy;
+
+    return order;
+  };
+
+  auto feed = [&book](std::vector<dxf_order_t> orders, bool newSnap) {
+    dxf_snapshot_data_t snapshotData{};
+
+    snapshotData.event_type = DXF_ET_ORDER;
+    snapshotData.records_count = orders.size();
+    snapshotData.records = orders.data();
+    book->processSnapshotData(&snapshotData, newSnap ? 1 : 0);
+  };
+
+  auto expect = [&](std::size_t newBooks, std::size_t changes, std::size_t bids) {
+    return newBooksNumber == newBooks && changesNumber == changes && bidsNumber == bids;
+  };
+
+  // The new snapshot without SNAPSHOT_END
+  feed({makeOrder(1, 100.0, 1.0, dxf_ef_snapshot_begin), makeOrder(2, 99.0, 1.0, 0)}, true);
+
+  auto isConsistent = expect(1, 0, 2);
+
+  // The transaction of two incremental updates
+  feed({makeOrder(3, 98.0, 1.0, dxf_ef_tx_pending)}, false);
+  isConsistent = isConsistent && expect(1, 0, 2);
+  feed({makeOrder(4, 97.0, 1.0, 0)}, false);
+  isConsistent = isConsistent && expect(1, 1, 4);
+
+  // The snapshot flags of the incremental update do not keep it pending
+  feed({makeOrder(5, 96.0, 1.0, dxf_ef_snapshot_begin)}, false);
+  isConsistent = isConsistent && expect(1, 2, 5);
+
+  // The new snapshot drops the pending transaction and is applied even with TX_PENDING
+  feed({makeOrder(6, 95.0, 1.0, dxf_ef_tx_pending)}, false);
+  feed({makeOrder(1, 100.0, 1.0, dxf_ef_snapshot_begin | dxf_ef_tx_pending)}, true);
+  isConsistent = isConsistent && expect(2, 2, 1);
+
+  // The incremental updates after it are applied
+  feed({makeOrder(1, 100.0, 0.0, dxf_ef_remove_event)}, false);
+  isConsistent = isConsistent && expect(2, 3, 0);
+
+  fmt::print("{:<32} {:>8}\n", "Book transactions", isConsistent ? "OK" : "FAILED");
+
+  return isConsistent;
+}
+
+// The price level size changes grouped into the batches (best first per side), like the ones produced by the
+// PriceLevelBookCore::convertToUpdates
+template <typename Level>
+struct LevelChangesBatches {
+  struct Batch {
+    std::size_t asksBegin;
+    std::size_t asksEnd;
+    std::size_t bidsBegin;
+    std::size_t bidsEnd;
+  };
+
+  std::vector<Level> asks{};
+  std::vector<Level> bids{};
+  std::vector<Batch> batches{};
+};
+
+template <typename Numbers>
+LevelChangesBatches<typename Numbers::Level> toLevelChangesBatches(const std::vector<LevelUpdate<double>>& updates,
+                                                                   const Numbers& numbers, std::size_t batchSize) {
+  using Number = typename Numbers::Number;
+  using Level = typename Numbers::Level;
+
+  LevelChangesBatches<Level> result{};
+  std::map<Number, Number> askSizes{};
+  std::map<Number, Number> bidSizes{};
+
+  // Appends the change to the batch side, the changes with the same price are summed up
+  auto addChange = [](std::vector<Level>& side, std::size_t begin, const Level& change) {
+    auto found = std::find_if(side.begin() + static_cast<std::ptrdiff_t>(begin), side.end(),
+                              [&change](const Level& l) { return l.price == change.price; });
+
+    if (found == side.end()) {
+      side.push_back(change);
+    } else {
+      found->size += change.size;
+    }
+  };
+
+  auto finishSide = [](std::vector<Level>& side, std::size_t begin, bool isBid) {
+    side.erase(std::remove_if(side.begin() + static_cast<std::ptrdiff_t>(begin), side.end(),
+                              [](const Level& l) { return Numbers::isZero(l.size); }),
+               side.end());
+    std::sort(side.begin() + static_cast<std::ptrdiff_t>(begin), side.end(), [isBid](const Level& l1, const Level& l2) {
+      return isBid ? l1.price > l2.price : l1.price < l2.price;
+    });
+  };
+
+  for (std::size_t i = 0; i < updates.size(); i += batchSize) {
+    typename LevelChangesBatches<Level>::Batch batch{result.asks.size(), 0, result.bids.size(), 0};
+
+    for (std::size_t j = i; j < (std::min)(i + batchSize, updates.size()); j++) {
+      auto isBid = updates[j].side == dxf::PriceLevelSide::BID;
+      auto& sizes = isBid ? bidSizes : askSizes;
+      auto price = numbers.toPrice(updates[j].price);
+      auto size = numbers.toSize(updates[j].size);
+      auto& currentSize = sizes[price];
+
+      addChange(isBid ? result.bids : result.asks, isBid ? batch.bidsBegin : batch.asksBegin,
+                Level{price, size - currentSize, static_cast<std::int64_t>(j)});
+      currentSize = size;
+    }
+
+    finishSide(result.asks, batch.asksBegin, false);
+    finishSide(result.bids, batch.bidsBegin, true);
+    batch.asksEnd = result.asks.size();
+    batch.bidsEnd = result.bids.size();
+    result.batches.push_back(batch);
+  }
+
+  return result;
+}
+
+// Applies the price level changes to the PriceLevelBookCore and copies the visible book after each batch (as the
+// PriceLevelBook does before calling the handlers). The first half of the batches warms up the book, the time and the
+// allocations are measured for the second half.
+// Removes all the levels of the book built by the updates: the analytics of the empty book must be exactly zero (not
+// the residue of the accumulated floating point deltas), the prices must be NaN
+template <typename Numbers, template <typename> class Ladder>
+bool checkEmptyAnalytics(const std::string& name, const Numbers& numbers, double tickSize,
+                         const std::vector<LevelUpdate<double>>& updates, std::size_t batchSize) {
+  using Level = typename Numbers::Level;
+
+  auto batches = toLevelChangesBatches(updates, numbers, batchSize);
+  dxf::PriceLevelBookCore<Numbers, Ladder<Level>> core{numbers, 0, tickSize};
+  dxf::BasicPriceLevelChanges<Level> levelChanges{};
+  dxf::PriceLevelChangesSet changesSet{};
+  dxf::PriceLevelChanges book{};
+
+  for (const auto& batch : batches.batches) {
+    levelChanges.asks.assign(batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksBegin),
+                             batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksEnd));
+    levelChanges.bids.assign(batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsBegin),
+                             batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsEnd));
+    core.applyUpdates(levelChanges, changesSet);
+  }
+
+  core.copyBook(book);
+
+  auto toRemovals = [&numbers](const std::vector<dxf::PriceLevel>& levels, std::vector<Level>& removals) {
+    removals.clear();
+
+    for (const auto& level : levels) {
+      removals.push_back(Level{numbers.toPrice(level.price), numbers.toSize(-level.size), level.time});
+    }
+  };
+
+  toRemovals(book.asks, levelChanges.asks);
+  toRemovals(book.bids, levelChanges.bids);
+  core.applyUpdates(levelChanges, changesSet);
+
+  auto analytics = core.getAnalytics();
+  auto isEmptySide = [](const dxf::PriceLevelSideAnalytics& side) {
+    return side.levelsNumber == 0 && side.size == 0.0 && side.notional == 0.0 && std::isnan(side.getWeightedPrice());
+  };
+  auto isConsistent = !book.asks.empty() && !book.bids.empty() && isEmptySide(analytics.asks) &&
+                      isEmptySide(analytics.bids) && analytics.isEmpty() && std::isnan(analytics.getImbalance());
+
+  fmt::print("{:<32} {:>8}\n", name, isConsistent ? "OK" : "FAILED");
+
+  return isConsistent;
+}
+
+template <typename Numbers, template <typename> class Ladder>
+void runBook(const std::string& name, const Numbers& numbers, double tickSize,
+             const std::vector<LevelUpdate<double>>& updates, std::size_t levelsNumber, std::size_t batchSize) {
+  using Level = typename Numbers::Level;
+
+  auto batches = toLevelChangesBatches(updates, numbers, batchSize);
+  dxf::PriceLevelBookCore<Numbers, Ladder<Level>> core{numbers, levelsNumber, tickSize};
+  dxf::BasicPriceLevelChanges<Level> levelChanges{};
+  dxf::PriceLevelChangesSet changesSet{};
+  dxf::PriceLevelChanges book{};
+
+  auto apply = [&](std::size_t from, std::size_t to) {
+    for (std::size_t i = from; i < to; i++) {
+      const auto& batch = batches.batches[i];
+
+      levelChanges.asks.assign(batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksBegin),
+                               batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksEnd));
+      levelChanges.bids.assign(batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsBegin),
+                               batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsEnd));
+      core.applyUpdates(levelChanges, changesSet);
+      core.copyBook(book);
+    }
+  };
+
+  auto half = batches.batches.size() / 2;
+
+  apply(0, half);
+
+  auto allocationsBefore = allocationsNumber.load();
+  auto start = std::chrono::steady_clock::now();
+
+  apply(half, batches.batches.size());
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  auto allocations = allocationsNumber.load() - allocationsBefore;
+  auto measuredUpdates = static_cast<double>(updates.size() - (std::min)(half * batchSize, updates.size()));
+
+  sink = static_cast<double>(book.asks.size() + book.bids.size());
+
+  fmt::print("{:<16} {:>12.1f} {:>14.4f}\n", name, static_cast<double>(elapsed.count()) / measuredUpdates,
+             static_cast<double>(allocations) / measuredUpdates);
+}
+
+template <typename Value>
+const Value* findValue(const std::unordered_map<dxf_long_t, Value>& map, dxf_long_t key) {
+  auto found = map.find(key);
+
+  return found == map.end() ? nullptr : &found->second;
+}
+
+template <typename Value>
+const Value* findValue(const dxf::FlatHashMap<dxf_long_t, Value>& map, dxf_long_t key) {
+  return map.find(key);
+}
+
+const char* toString(dxf::PriceSearchKernel kernel) {
+  switch (kernel) {
+    case dxf::PriceSearchKernel::AVX2:
+      return "AVX2";
+    case dxf::PriceSearchKernel::SSE42:
+      return "SSE4.2";
+    default:
+      return "SCALAR";
+  }
+}
+
+template <typename Clock = std::chrono::steady_clock>
+double nsPerOperation(typename Clock::time_point start, std::size_t operationsNumber) {
+  return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()) /
+         static_cast<double>(operationsNumber);
+}
+
+// The consumer of the handlers benchmark: reads the changes and the best levels of every notification
+struct BestLevelsHandler {
+  std::size_t notificationsNumber = 0;
+  double checksum = 0.0;
+
+  void onIncrementalChange(const dxf::PriceLevelChangesSet& changesSet) {
+    notificationsNumber++;
+    checksum += static_cast<double>(changesSet.additions.asks.size() + changesSet.additions.bids.size() +
+                                    changesSet.removals.asks.size() + changesSet.removals.bids.size());
+  }
+
+  void onBookUpdateView(const dxf::PriceLevelBookView& view) {
+    if (!view.asks.empty()) checksum += (*view.asks.begin()).price;
+    if (!view.bids.empty()) checksum += (*view.bids.begin()).price;
+  }
+};
+
+// The handler of the BasicPriceLevelBook that calls the BestLevelsHandler directly
+struct StaticBestLevelsHandler {
+  BestLevelsHandler* handler;
+
+  void onIncrementalChange(const dxf::PriceLevelChangesSet& changesSet) const {
+    handler->onIncrementalChange(changesSet);
+  }
+
+  void onBookUpdateView(const dxf::PriceLevelBookView& view) const { handler->onBookUpdateView(view); }
+};
+
+// Measures the notification of the book handler (see dxf::PriceLevelBookHandlerTraits::notifyUpdate) in the same way
+// as the BasicPriceLevelBook notifies it: the same core and changes are notified repeatedly, so only the dispatch and
+// the consumer are measured. The best of the runs is taken.
+template <typename Handler, typename Core>
+double runHandlers(const std::string& name, Handler& handler, BestLevelsHandler& consumer, Core& core,
+                   const dxf::PriceLevelChangesSet& changesSet, std::size_t notificationsNumber,
+                   double referenceNsPerNotification) {
+  const std::size_t runsNumber = 3;
+  dxf::PriceLevelChanges book{};
+  double nsPerNotification = 0.0;
+  double allocationsPerNotification = 0.0;
+
+  for (std::size_t r = 0; r < runsNumber; r++) {
+    auto allocationsBefore = allocationsNumber.load();
+    auto start = std::chrono::steady_clock::now();
+
+    for (std::size_t i = 0; i < notificationsNumber; i++) {
+      dxf::PriceLevelBookHandlerTraits<Handler>::notifyUpdate(handler, core, changesSet, book);
+    }
+
+    auto runNsPerNotification = nsPerOperation(start, notificationsNumber);
+
+    if (r == 0 || runNsPerNotification < nsPerNotification) {
+      nsPerNotification = runNsPerNotification;
+      allocationsPerNotification = static_cast<double>(allocationsNumber.load() - allocationsBefore) /
+                                   static_cast<double>(notificationsNumber);
+    }
+  }
+
+  sink = consumer.checksum + static_cast<double>(consumer.notificationsNumber);
+
+  auto saving = referenceNsPerNotification > 0.0
+                  ? fmt::format("{:.2f}", referenceNsPerNotification - nsPerNotification)
+                  : std::string{"-"};
+
+  fmt::print("{:<16} {:>12.2f} {:>14.4f} {:>12}\n", name, nsPerNotification, allocationsPerNotification, saving);
+
+  return nsPerNotification;
+}
+
+// Measures the order index operations: the snapshot rebuild (clear + insert), the lookups of the existing orders and
+// the churn (remove an order, add a new one)
+template <typename Map>
+void runOrderIndex(const std::string& name, const std::vector<dxf_long_t>& indices, std::size_t snapshotSize,
+                   bool reserve, std::uint64_t seed) {
+  const std::size_t rebuildsNumber = 10;
+  Map map{};
+  std::mt19937_64 rng{seed};
+
+  if (reserve) {
+    map.reserve(snapshotSize);
+  }
+
+  auto allocationsBefore = allocationsNumber.load();
+  auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t r = 0; r < rebuildsNumber; r++) {
+    map.clear();
+
+    for (std::size_t i = 0; i < snapshotSize; i++) {
+      auto index = indices[i];
+
+      map[index] = dxf::OrderData{index, 100.0 + static_cast<double>(i % 1000) * 0.01, 1.0, 0, dxf_osd_buy};
+    }
+  }
+
+  auto rebuildNs = nsPerOperation(start, rebuildsNumber * snapshotSize);
+  auto rebuildAllocations = static_cast<double>(allocationsNumber.load() - allocationsBefore) /
+                            static_cast<double>(rebuildsNumber * snapshotSize);
+
+  std::uniform_int_distribution<std::size_t> existing{0, snapshotSize - 1};
+  std::vector<dxf_long_t> lookups(snapshotSize);
+
+  for (auto& lookup : lookups) lookup = indices[existing(rng)];
+
+  double checksum = 0.0;
+
+  start = std::chrono::steady_clock::now();
+
+  for (auto index : lookups) {
+    if (const auto* orderData = findValue(map, index); orderData != nullptr) checksum += orderData->price;
+  }
+
+  auto lookupNs = nsPerOperation(start, lookups.size());
+
+  // The orders [begin, begin + snapshotSize) are in the map, the churn removes the oldest one and adds the next one
+  auto churnNumber = indices.size() - snapshotSize;
+
+  allocationsBefore = allocationsNumber.load();
+  start = std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0; i < churnNumber; i++) {
+    map.erase(indices[i]);
+    map[indices[snapshotSize + i]] = dxf::OrderData{indices[snapshotSize + i], 100.0, 1.0, 0, dxf_osd_sell};
+  }
+
+  auto churnNs = nsPerOperation(start, churnNumber);
+  auto churnAllocations =
+    static_cast<double>(allocationsNumber.load() - allocationsBefore) / static_cast<double>(churnNumber);
+
+  sink = checksum;
+
+  fmt::print("{:<24} {:>10.1f} {:>10.4f} {:>10.1f} {:>10.1f} {:>10.4f}\n", name, rebuildNs, rebuildAllocations,
+             lookupNs, churnNs, churnAllocations);
+}
+
+// The writer applies the batches to the book in a loop, the readers copy the best levels: under the book mutex (the
+// way the handlers see the book) or from the PriceLevelTopPublisher
+void runTopReaders(const std::string& name, const LevelChangesBatches<dxf::PriceLevel>& batches, double tickSize,
+                   std::size_t levelsNumber, std::size_t readersNumber, bool isLockFree) {
+  const auto duration = std::chrono::milliseconds(300);
+
+  dxf::PriceLevelBookCore<dxf::FloatingPointPriceLevelNumbers, dxf::TickPriceLevelLadder<dxf::PriceLevel>> core{
+    dxf::FloatingPointPriceLevelNumbers{}, levelsNumber, tickSize};
+  dxf::PriceLevelTopPublisher publisher{levelsNumber == 0 ? 10 : levelsNumber};
+  std::mutex mutex{};
+  std::atomic<bool> isStopped{false};
+  std::atomic<std::uint64_t> readsNumber{0};
+  std::atomic<std::uint64_t> retriesNumber{0};
+  std::atomic<std::int64_t> readNs{0};
+  std::uint64_t writesNumber = 0;
+
+  std::vector<std::thread> readers{};
+
+  for (std::size_t r = 0; r < readersNumber; r++) {
+    readers.emplace_back([&] {
+      dxf::PriceLevelTop top{};
+      dxf::PriceLevelChanges book{};
+      std::uint64_t reads = 0;
+      std::uint64_t retries = 0;
+      auto start = std::chrono::steady_clock::now();
+
+      while (!isStopped.load(std::memory_order_relaxed)) {
+        if (isLockFree) {
+          retries += publisher.read(top);
+        } else {
+          std::lock_guard<std::mutex> lk(mutex);
+
+          core.copyBook(book);
+        }
+
+        reads++;
+      }
+
+      readNs.fetch_add(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+      readsNumber.fetch_add(reads);
+      retriesNumber.fetch_add(retries);
+    });
+  }
+
+  dxf::BasicPriceLevelChanges<dxf::PriceLevel> levelChanges{};
+  dxf::PriceLevelChangesSet changesSet{};
+  auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t i = 0; std::chrono::steady_clock::now() - start < duration; i = (i + 1) % batches.batches.size()) {
+    const auto& batch = batches.batches[i];
+
+    // Restart the book when the batches wrap around
+    if (i == 0) {
+      std::lock_guard<std::mutex> lk(mutex);
+
+      core.clear();
+    }
+
+    levelChanges.asks.assign(batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksBegin),
+                             batches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksEnd));
+    levelChanges.bids.assign(batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsBegin),
+                             batches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsEnd));
+
+    {
+      std::lock_guard<std::mutex> lk(mutex);
+
+      core.applyUpdates(levelChanges, changesSet);
+
+      if (isLockFree) {
+        publisher.publish(core.getView());
+      }
+    }
+
+    writesNumber++;
+  }
+
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  isStopped = true;
+
+  for (auto& reader : readers) reader.join();
+
+  fmt::print("{:<16} {:>8} {:>12.1f} {:>12.4f} {:>14.1f}\n", name, readersNumber,
+             static_cast<double>(readNs.load()) / static_cast<double>((std::max)(readsNumber.load(), std::uint64_t{1})),
+             static_cast<double>(retriesNumber.load()) /
+               static_cast<double>((std::max)(readsNumber.load(), std::uint64_t{1})),
+             static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()) /
+               static_cast<double>(writesNumber));
+}
+
+int main(int argc, char* argv[]) {
+  if (argc > 1 && (std::string(argv[1]) == "-h" || std::string(argv[1]) == "--help")) {
+    std::cout << "Usage:\n  plb-bench [<number of levels> [<number of updates> [<book depth> [<seed>]]]]\n\n";
+
+    return 0;
+  }
+
+  std::size_t levelsNumber = argc > 1 ? std::stoull(argv[1]) : 10;
+  std::size_t updatesNumber = argc > 2 ? std::stoull(argv[2]) : 5000000;
+  std::size_t depth = argc > 3 ? std::stoull(argv[3]) : 500;
+  std::uint64_t seed = argc > 4 ? std::stoull(argv[4]) : 42;
+  const double tickSize = 0.01;
+
+  auto updates = generateUpdates(updatesNumber, depth, tickSize, seed);
+
+  dxf::OrderedPriceLevelLadder<dxf::PriceLevel> referenceAsks{dxf::PriceLevelSide::ASK};
+  dxf::OrderedPriceLevelLadder<dxf::PriceLevel> referenceBids{dxf::PriceLevelSide::BID};
+  auto referenceNsPerUpdate = run(referenceAsks, referenceBids, updates, levelsNumber);
+  auto floatingPoint = dxf::FloatingPointPriceLevelNumbers{};
+  auto fixedPoint = dxf::FixedPointPriceLevelNumbers{};
+
+  fmt::print("Updates: {}, levels: {}, depth: {}, seed: {}, SHALLOW search kernel: {}\n", updatesNumber, levelsNumber,
+             depth, seed, toString(dxf::PriceSearch::getKernel()));
+  fmt::print("{:<16} {:>12} {:>11} {:>8}\n", "Ladder", "ns/update", "Speedup", "Check");
+  fmt::print("{:<16} {:>12.1f} {:>10.2f}x {:>8}\n", "ORDERED", referenceNsPerUpdate, 1.0, "-");
+
+  auto isConsistent =
+    runAndCheck<dxf::FloatingPointPriceLevelNumbers, dxf::TickPriceLevelLadder>(
+      "TICK", floatingPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks, referenceBids) &
+    runAndCheck<dxf::FixedPointPriceLevelNumbers, dxf::OrderedPriceLevelLadder>(
+      "ORDERED FIXED", fixedPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks,
+      referenceBids) &
+    runAndCheck<dxf::FixedPointPriceLevelNumbers, dxf::TickPriceLevelLadder>(
+      "TICK FIXED", fixedPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks, referenceBids) &
+    runAndCheck<dxf::FloatingPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>(
+      "SHALLOW", floatingPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks, referenceBids) &
+    runAndCheck<dxf::FixedPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>(
+      "SHALLOW FIXED", fixedPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks, referenceBids);
+
+  // The same SHALLOW ladders with the scalar search kernel
+  auto supportedKernel = dxf::PriceSearch::getSupportedKernel();
+
+  dxf::PriceSearch::setKernel(dxf::PriceSearchKernel::SCALAR);
+  isConsistent =
+    runAndCheck<dxf::FloatingPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>(
+      "SHALLOW SCALAR", floatingPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks,
+      referenceBids) &
+    runAndCheck<dxf::FixedPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>(
+      "SHALLOW FIXED SC", fixedPoint, tickSize, updates, levelsNumber, referenceNsPerUpdate, referenceAsks,
+      referenceBids) &
+    isConsistent;
+  dxf::PriceSearch::setKernel(supportedKernel);
+
+  fmt::print("\n{:<32} {:>8}\n", "Check", "Result");
+  isConsistent = checkTickOutliers("TICK outliers", floatingPoint, tickSize, updates) &
+                 checkTickOutliers("TICK FIXED outliers", fixedPoint, tickSize, updates) & checkTransactions() &
+                 checkEmptyAnalytics<dxf::FloatingPointPriceLevelNumbers, dxf::OrderedPriceLevelLadder>(
+                   "Empty book analytics", floatingPoint, tickSize, updates, 4) &
+                 checkEmptyAnalytics<dxf::FixedPointPriceLevelNumbers, dxf::TickPriceLevelLadder>(
+                   "Empty book analytics FIXED", fixedPoint, tickSize, updates, 4) &
+                 isConsistent;
+
+  const std::size_t batchSize = 4;
+
+  fmt::print("\nBook (the changes are applied by {} updates)\n", batchSize);
+  fmt::print("{:<16} {:>12} {:>14}\n", "Ladder", "ns/update", "allocs/update");
+  runBook<dxf::FloatingPointPriceLevelNumbers, dxf::OrderedPriceLevelLadder>("ORDERED", floatingPoint, tickSize,
+                                                                              updates, levelsNumber, batchSize);
+  runBook<dxf::FloatingPointPriceLevelNumbers, dxf::TickPriceLevelLadder>("TICK", floatingPoint, tickSize, updates,
+                                                                           levelsNumber, batchSize);
+  runBook<dxf::FixedPointPriceLevelNumbers, dxf::OrderedPriceLevelLadder>("ORDERED FIXED", fixedPoint, tickSize,
+                                                                           updates, levelsNumber, batchSize);
+  runBook<dxf::FixedPointPriceLevelNumbers, dxf::TickPriceLevelLadder>("TICK FIXED", fixedPoint, tickSize, updates,
+                                                                        levelsNumber, batchSize);
+  runBook<dxf::FloatingPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>("SHALLOW", floatingPoint, tickSize,
+                                                                              updates, levelsNumber, batchSize);
+  runBook<dxf::FixedPointPriceLevelNumbers, dxf::ShallowPriceLevelLadder>("SHALLOW FIXED", fixedPoint, tickSize,
+                                                                           updates, levelsNumber, batchSize);
+
+  // The book state and the changes of the last batch (the SHALLOW book) are notified to the handlers
+  auto handlersBatches = toLevelChangesBatches(updates, floatingPoint, batchSize);
+  dxf::PriceLevelBookCore<dxf::FloatingPointPriceLevelNumbers,
+                          dxf::ShallowPriceLevelLadder<dxf::FloatingPointPriceLevelNumbers::Level>>
+    handlersCore{floatingPoint, levelsNumber, tickSize};
+  dxf::BasicPriceLevelChanges<dxf::FloatingPointPriceLevelNumbers::Level> handlersLevelChanges{};
+  dxf::PriceLevelChangesSet handlersChangesSet{};
+
+  for (const auto& batch : handlersBatches.batches) {
+    handlersLevelChanges.asks.assign(handlersBatches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksBegin),
+                                     handlersBatches.asks.begin() + static_cast<std::ptrdiff_t>(batch.asksEnd));
+    handlersLevelChanges.bids.assign(handlersBatches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsBegin),
+                                     handlersBatches.bids.begin() + static_cast<std::ptrdiff_t>(batch.bidsEnd));
+    handlersCore.applyUpdates(handlersLevelChanges, handlersChangesSet);
+  }
+
+  const std::size_t notificationsNumber = 10000000;
+  BestLevelsHandler consumer{};
+  dxf::FunctionPriceLevelBookHandler functionHandler{};
+  StaticBestLevelsHandler staticHandler{&consumer};
+
+  functionHandler.setOnIncrementalChange(
+    [&consumer](const dxf::PriceLevelChangesSet& changesSet) { consumer.onIncrementalChange(changesSet); });
+  functionHandler.setOnBookUpdateView(
+    [&consumer](const dxf::PriceLevelBookView& view) { consumer.onBookUpdateView(view); });
+
+  fmt::print("\nHandlers (onIncrementalChange + onBookUpdateView, {} notifications)\n", notificationsNumber);
+  fmt::print("{:<16} {:>12} {:>14} {:>12}\n", "Handler", "ns/notif", "allocs/notif", "saving ns");
+
+  auto functionNsPerNotification = runHandlers("std::function", functionHandler, consumer, handlersCore,
+                                               handlersChangesSet, notificationsNumber, 0.0);
+
+  runHandlers("static", staticHandler, consumer, handlersCore, handlersChangesSet, notificationsNumber,
+              functionNsPerNotification);
+
+  const std::size_t snapshotSize = 200000;
+  std::mt19937_64 indicesRng{seed};
+  std::vector<dxf_long_t> indices(snapshotSize * 2);
+
+  // The order indices are sparse 64-bit numbers (the source bits + the exchange order id)
+  for (auto& index : indices) index = static_cast<dxf_long_t>(indicesRng() >> 8U);
+
+  auto topBatches = toLevelChangesBatches(updates, floatingPoint, batchSize);
+
+  fmt::print("\nTop of book readers (the writer updates the book continuously)\n");
+  fmt::print("{:<16} {:>8} {:>12} {:>12} {:>14}\n", "Reader", "Threads", "ns/read", "retries/read", "ns/write");
+
+  for (std::size_t readersNumber : {1, 2, 4}) {
+    runTopReaders("MUTEX", topBatches, tickSize, levelsNumber, readersNumber, false);
+    runTopReaders("SEQLOCK", topBatches, tickSize, levelsNumber, readersNumber, true);
+  }
+
+  fmt::print("\nOrder index ({} orders)\n", snapshotSize);
+  fmt::print("{:<24} {:>10} {:>10} {:>10} {:>10} {:>10}\n", "Map", "rebuild ns", "allocs", "lookup ns", "churn ns",
+             "allocs");
+  runOrderIndex<std::unordered_map<dxf_long_t, dxf::OrderData>>("std::unordered_map", indices, snapshotSize, false,
+                                                                seed);
+  runOrderIndex<std::unordered_map<dxf_long_t, dxf::OrderData>>("std::unordered_map (res)", indices, snapshotSize, true,
+                                                                seed);
+  runOrderIndex<dxf::FlatHashMap<dxf_long_t, dxf::OrderData>>("FlatHashMap", indices, snapshotSize, false, seed);
+  runOrderIndex<dxf::FlatHashMap<dxf_long_t, dxf::OrderData>>("FlatHashMap (res)", indices, snapshotSize, true, seed);
+
+  return isConsistent ? 0 : 1;
+}